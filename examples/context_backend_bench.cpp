@@ -0,0 +1,141 @@
+/*
+ * Event-to-handler latency and throughput of the async_context backends.
+ *
+ * Core 1 initialises a ContextBackend of kind BENCH_BACKEND (0 =
+ * threadsafe_background, 1 = poll, 2 = FreeRTOS) and registers one
+ * when-pending worker. Core 0 is the event source: it stamps time_us_32()
+ * and calls async_context_set_work_pending(), as a lwIP callback or a
+ * bridge would. The worker records stamp-to-handler latency in a
+ * LatencyHistogram.
+ *
+ *  - latency:    BENCH_SAMPLES events, one at a time, BENCH_GAP_US apart.
+ *  - throughput: ping-pong for BENCH_THROUGHPUT_MS; the next event is
+ *                raised as soon as the previous handler has run.
+ *
+ * With the poll backend loop1() busy-polls the context. Build once per
+ * backend (FreeRTOS needs a FreeRTOS SMP build) and compare the lines:
+ *
+ *   CTXBENCH backend=poll p50_us=.. p99_us=.. max_us=.. events_per_s=..
+ *
+ * context_backend_bench_host.cpp models the same three on a host.
+ */
+#include "ContextBackend.hpp"
+#include "LatencyHistogram.hpp"
+
+#include <Arduino.h>
+#include <atomic>
+#include <pico/time.h>
+
+#ifndef BENCH_BACKEND
+#define BENCH_BACKEND ASYNC_TCP_CONTEXT_BACKEND
+#endif
+#ifndef BENCH_SAMPLES
+#define BENCH_SAMPLES 10000
+#endif
+#ifndef BENCH_GAP_US
+#define BENCH_GAP_US 200
+#endif
+#ifndef BENCH_THROUGHPUT_MS
+#define BENCH_THROUGHPUT_MS 2000
+#endif
+
+using namespace async_tcp;
+
+namespace {
+
+    constexpr auto KIND = static_cast<ContextBackend::Kind>(BENCH_BACKEND);
+
+    ContextBackend backend;
+    async_when_pending_worker_t worker{};
+    LatencyHistogram latency;
+    std::atomic<uint32_t> stamp{0};
+    std::atomic<uint32_t> handled{0};
+    std::atomic<bool> record{true};
+    std::atomic<bool> ready{false};
+
+    void onEvent(async_context_t *, async_when_pending_worker_t *) {
+        if (record.load(std::memory_order_relaxed)) {
+            latency.record(time_us_32() -
+                           stamp.load(std::memory_order_acquire));
+        }
+        handled.fetch_add(1, std::memory_order_release);
+    }
+
+    void raise() {
+        stamp.store(time_us_32(), std::memory_order_release);
+        async_context_set_work_pending(backend.context(), &worker);
+    }
+
+    bool waitHandled(const uint32_t count, const uint32_t timeout_us) {
+        const uint32_t start = time_us_32();
+        while (handled.load(std::memory_order_acquire) < count) {
+            if (time_us_32() - start > timeout_us) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+} // namespace
+
+void setup() {
+    Serial1.begin(115200);
+    while (!ready.load(std::memory_order_acquire)) {
+        delay(1);
+    }
+    if (!backend.context()) {
+        Serial1.printf("CTXBENCH backend=%s unavailable\n",
+                       ContextBackend::name(KIND));
+        return;
+    }
+
+    uint32_t lost = 0;
+    for (uint32_t i = 0; i < BENCH_SAMPLES; ++i) {
+        const uint32_t target = handled.load() + 1;
+        raise();
+        lost += waitHandled(target, 100000) ? 0 : 1;
+        busy_wait_us_32(BENCH_GAP_US);
+    }
+
+    record.store(false);
+    const uint32_t base = handled.load();
+    const uint32_t start = time_us_32();
+    uint32_t raised = 0;
+    while (time_us_32() - start < BENCH_THROUGHPUT_MS * 1000u) {
+        raise();
+        ++raised;
+        if (!waitHandled(base + raised, 100000)) {
+            ++lost;
+            break;
+        }
+    }
+    const uint32_t elapsed = time_us_32() - start;
+
+    const auto s = latency.snapshot();
+    Serial1.printf("CTXBENCH backend=%s p50_us=%lu p99_us=%lu max_us=%lu "
+                   "events_per_s=%lu lost=%lu\n",
+                   ContextBackend::name(KIND),
+                   static_cast<unsigned long>(s.percentile(50)),
+                   static_cast<unsigned long>(s.percentile(99)),
+                   static_cast<unsigned long>(s.max_us),
+                   static_cast<unsigned long>(
+                       static_cast<uint64_t>(handled.load() - base) *
+                       1000000ULL / elapsed),
+                   static_cast<unsigned long>(lost));
+}
+
+void loop() { delay(1000); }
+
+void setup1() {
+    if (backend.init(KIND, 1)) {
+        worker.do_work = onEvent;
+        async_context_add_when_pending_worker(backend.context(), &worker);
+    }
+    ready.store(true, std::memory_order_release);
+}
+
+void loop1() {
+    // Dedicated core: poll without sleeping. The other backends run the
+    // worker from their IRQ or task.
+    backend.poll();
+}
@@ -0,0 +1,182 @@
+/*
+ * Host model of context_backend_bench.cpp: the same latency and ping-pong
+ * throughput measurement, with std::thread standing in for core 1.
+ *
+ *  - threadsafe_background: the handler thread sleeps on a condition
+ *    variable and runs the worker under the context's recursive lock, as
+ *    the low-priority IRQ does.
+ *  - poll: the handler thread spins on the pending flag (dedicated core).
+ *  - freertos: a task blocked on a binary semaphore, woken per event and
+ *    yielding after each dispatch.
+ *
+ * Absolute numbers say nothing about the RP2040; the relative order and
+ * the tail behaviour of spin vs. blocking wake-up do carry over. The poll
+ * model needs a free host core, as on the device; with a single CPU the
+ * spinning thread starves the event source.
+ *
+ *   g++ -std=c++17 -O2 -pthread context_backend_bench_host.cpp -o ctxbench
+ *   ./ctxbench [samples]
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+    using Clock = std::chrono::steady_clock;
+
+    uint64_t nowNs() {
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                Clock::now().time_since_epoch())
+                .count());
+    }
+
+    enum class Kind { Background, Poll, FreeRtos };
+
+    const char *name(const Kind kind) {
+        switch (kind) {
+        case Kind::Background:
+            return "threadsafe_background";
+        case Kind::Poll:
+            return "poll";
+        case Kind::FreeRtos:
+            return "freertos";
+        }
+        return "?";
+    }
+
+    class Context {
+        public:
+            explicit Context(const Kind kind) : m_kind(kind) {
+                m_thread = std::thread([this] { loop(); });
+            }
+
+            ~Context() {
+                m_stop.store(true);
+                wake();
+                m_thread.join();
+            }
+
+            void raise() {
+                m_stamp.store(nowNs(), std::memory_order_release);
+                m_pending.store(true, std::memory_order_release);
+                wake();
+            }
+
+            uint64_t handled() const {
+                return m_handled.load(std::memory_order_acquire);
+            }
+
+            std::vector<uint32_t> latencies_ns;
+            std::atomic<bool> record{true};
+
+        private:
+            void wake() {
+                if (m_kind != Kind::Poll) {
+                    std::lock_guard<std::mutex> g(m_wake_mutex);
+                    m_signal = true;
+                    m_cv.notify_one();
+                }
+            }
+
+            void dispatch() {
+                if (!m_pending.exchange(false, std::memory_order_acq_rel)) {
+                    return;
+                }
+                std::lock_guard<std::recursive_mutex> g(m_lock);
+                if (record.load(std::memory_order_relaxed)) {
+                    latencies_ns.push_back(static_cast<uint32_t>(
+                        nowNs() - m_stamp.load(std::memory_order_acquire)));
+                }
+                m_handled.fetch_add(1, std::memory_order_release);
+            }
+
+            void loop() {
+                while (!m_stop.load(std::memory_order_relaxed)) {
+                    if (m_kind != Kind::Poll) {
+                        std::unique_lock<std::mutex> l(m_wake_mutex);
+                        m_cv.wait(l, [this] {
+                            return m_signal || m_stop.load();
+                        });
+                        m_signal = false;
+                    }
+                    dispatch();
+                    if (m_kind == Kind::FreeRtos) {
+                        std::this_thread::yield();
+                    }
+                }
+            }
+
+            Kind m_kind;
+            std::thread m_thread;
+            std::atomic<bool> m_stop{false};
+            std::atomic<bool> m_pending{false};
+            std::atomic<uint64_t> m_stamp{0};
+            std::atomic<uint64_t> m_handled{0};
+            std::recursive_mutex m_lock;
+            std::mutex m_wake_mutex;
+            std::condition_variable m_cv;
+            bool m_signal = false;
+    };
+
+    void waitHandled(const Context &ctx, const uint64_t count) {
+        while (ctx.handled() < count) {
+            std::this_thread::yield(); // hosts with fewer free cores
+        }
+    }
+
+    void bench(const Kind kind, const std::size_t samples) {
+        Context ctx(kind);
+        ctx.latencies_ns.reserve(samples);
+
+        for (std::size_t i = 0; i < samples; ++i) {
+            const uint64_t target = ctx.handled() + 1;
+            ctx.raise();
+            waitHandled(ctx, target);
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+
+        std::vector<uint32_t> lat = ctx.latencies_ns;
+        ctx.record.store(false);
+        const uint64_t base = ctx.handled();
+        const uint64_t start = nowNs();
+        uint64_t raised = 0;
+        while (nowNs() - start < 1000000000ULL) {
+            ctx.raise();
+            waitHandled(ctx, base + ++raised);
+        }
+        const uint64_t elapsed = nowNs() - start;
+
+        std::sort(lat.begin(), lat.end());
+        const auto pct = [&lat](const double p) {
+            return lat.empty() ? 0u
+                               : lat[static_cast<std::size_t>(
+                                     p / 100.0 * (lat.size() - 1))] /
+                                     1000u;
+        };
+        std::printf("CTXBENCH backend=%s p50_us=%u p99_us=%u max_us=%u "
+                    "events_per_s=%llu\n",
+                    name(kind), pct(50), pct(99),
+                    lat.empty() ? 0u : lat.back() / 1000u,
+                    static_cast<unsigned long long>(
+                        (ctx.handled() - base) * 1000000000ULL / elapsed));
+    }
+
+} // namespace
+
+int main(const int argc, char **argv) {
+    const std::size_t samples =
+        argc > 1 ? static_cast<std::size_t>(std::atoi(argv[1])) : 10000;
+    bench(Kind::Background, samples);
+    bench(Kind::Poll, samples);
+    bench(Kind::FreeRtos, samples);
+    return 0;
+}
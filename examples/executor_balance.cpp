@@ -0,0 +1,121 @@
+/*
+ * Work-stealing balance under load: LoadGenerator drives echo traffic
+ * against the local LoadServers while every received KiB submits a
+ * simulated handler task (FNV-1a over a scratch buffer) to the
+ * WorkStealingExecutor with Affinity::Any. Core 0 (networking) polls the
+ * generator and runs tasks between polls; core 1 only runs tasks, so it
+ * ends up stealing most of them.
+ *
+ * Every EXEC_REPORT_MS the sketch prints the load report and per-core
+ * utilization; with EXEC_STEALING=0 both cores keep their own work, which
+ * shows the imbalance stealing removes.
+ */
+#include "LoadGenerator.hpp"
+#include "LoadServers.hpp"
+#include "WorkStealingExecutor.hpp"
+#include "hash_util.hpp"
+#include "secrets.h" // WIFI_SSID, WIFI_PASSWORD
+
+#include <Arduino.h>
+#include <LwipEthernet.h>
+#include <WiFi.h>
+
+#ifndef EXEC_CONNECTIONS
+#define EXEC_CONNECTIONS 4
+#endif
+#ifndef EXEC_TASK_BYTES
+#define EXEC_TASK_BYTES 4096 // work per simulated handler task
+#endif
+#ifndef EXEC_REPORT_MS
+#define EXEC_REPORT_MS 5000
+#endif
+#ifndef EXEC_STEALING
+#define EXEC_STEALING 1
+#endif
+
+using namespace async_tcp;
+
+namespace {
+
+    LoadServers servers;
+    LoadGenerator *generator = nullptr;
+    WorkStealingExecutor executor(0);
+    uint8_t scratch[EXEC_TASK_BYTES];
+    volatile uint32_t sink = 0;
+    volatile bool core0_ready = false;
+
+    void handlerTask(void *) {
+        sink = sink + fnv1a(scratch, sizeof(scratch));
+    }
+
+    std::size_t runTasks(const uint32_t budget_us) {
+#if EXEC_STEALING
+        return executor.run(budget_us);
+#else
+        // Without stealing a core only drains what it submitted.
+        return executor.run(get_core_num() == 0 ? budget_us : 0);
+#endif
+    }
+
+} // namespace
+
+void setup() {
+    Serial1.begin(115200);
+    WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+    while (WiFi.status() != WL_CONNECTED) {
+        delay(100);
+    }
+
+    LoadGenerator::Config config;
+    config.server = WiFi.localIP();
+    config.port = LoadServers::ECHO_PORT;
+    config.mode = LoadGenerator::Mode::Echo;
+    config.connections = EXEC_CONNECTIONS;
+    config.message_size = 1024;
+    config.duration_ms = UINT32_MAX;
+
+    ethernet_arch_lwip_begin();
+    servers.beginAll();
+    generator = new LoadGenerator(config);
+    generator->start();
+    ethernet_arch_lwip_end();
+    executor.resetStats();
+    core0_ready = true;
+}
+
+void loop() {
+    static uint64_t rx_seen = 0;
+    static uint32_t last_report = millis();
+
+    ethernet_arch_lwip_begin();
+    generator->poll();
+    const auto report = generator->report();
+    ethernet_arch_lwip_end();
+
+    // One simulated handler per received KiB, as a bridge would submit.
+    for (; rx_seen + 1024 <= report.bytes_rx; rx_seen += 1024) {
+        if (!executor.submit(handlerTask, nullptr)) {
+            handlerTask(nullptr); // deque full: run inline
+        }
+    }
+    runTasks(1000);
+
+    if (millis() - last_report >= EXEC_REPORT_MS) {
+        last_report = millis();
+        LoadGenerator::print(report, Serial1);
+        executor.print(Serial1);
+        executor.resetStats();
+    }
+}
+
+void setup1() {
+    while (!core0_ready) {
+        tight_loop_contents();
+    }
+}
+
+void loop1() {
+    if (!runTasks(1000)) {
+        __wfe(); // submit() signals __sev()
+    }
+}
@@ -0,0 +1,113 @@
+/*
+ * Load generator: drives LoadGenerator against QOTD/echo/discard/chargen
+ * servers and prints connections/s, MB/s and latency percentiles.
+ *
+ * With LOAD_LOCAL_SERVERS the stand-in servers from LoadServers run on this
+ * board and the generator connects to its own address (needs
+ * LWIP_NETIF_LOOPBACK=1); otherwise set LOAD_SERVER_HOST in secrets.h.
+ *
+ * All knobs are compile-time defines so a test matrix can be built from
+ * the command line, e.g. -DLOAD_MODE=Discard -DLOAD_CONNECTIONS=8.
+ */
+#include "LoadGenerator.hpp"
+#include "LoadServers.hpp"
+#include "secrets.h" // WIFI_SSID, WIFI_PASSWORD[, LOAD_SERVER_HOST]
+
+#include <Arduino.h>
+#include <LwipEthernet.h>
+#include <WiFi.h>
+
+#ifndef LOAD_MODE
+#define LOAD_MODE Echo // Echo, Qotd, Discard, Chargen
+#endif
+#ifndef LOAD_CONNECTIONS
+#define LOAD_CONNECTIONS 4
+#endif
+#ifndef LOAD_MESSAGE_SIZE
+#define LOAD_MESSAGE_SIZE 256
+#endif
+#ifndef LOAD_THINK_MS
+#define LOAD_THINK_MS 0
+#endif
+#ifndef LOAD_DURATION_MS
+#define LOAD_DURATION_MS 30000
+#endif
+#ifndef LOAD_REQUESTS_PER_CONNECTION
+#define LOAD_REQUESTS_PER_CONNECTION 0
+#endif
+#ifndef LOAD_LOCAL_SERVERS
+#define LOAD_LOCAL_SERVERS 1
+#endif
+
+using namespace async_tcp;
+
+namespace {
+
+    LoadServers servers;
+    LoadGenerator *generator = nullptr;
+
+    uint16_t portFor(const LoadGenerator::Mode mode) {
+        switch (mode) {
+        case LoadGenerator::Mode::Qotd:
+            return LoadServers::QOTD_PORT;
+        case LoadGenerator::Mode::Discard:
+            return LoadServers::DISCARD_PORT;
+        case LoadGenerator::Mode::Chargen:
+            return LoadServers::CHARGEN_PORT;
+        default:
+            return LoadServers::ECHO_PORT;
+        }
+    }
+
+} // namespace
+
+void setup() {
+    Serial1.begin(115200);
+    WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+    while (WiFi.status() != WL_CONNECTED) {
+        delay(100);
+    }
+
+    LoadGenerator::Config config;
+    config.mode = LoadGenerator::Mode::LOAD_MODE;
+    config.port = portFor(config.mode);
+    config.connections = LOAD_CONNECTIONS;
+    config.message_size = LOAD_MESSAGE_SIZE;
+    config.think_time_ms = LOAD_THINK_MS;
+    config.duration_ms = LOAD_DURATION_MS;
+    config.requests_per_connection = LOAD_REQUESTS_PER_CONNECTION;
+
+#if LOAD_LOCAL_SERVERS
+    ethernet_arch_lwip_begin();
+    servers.beginAll();
+    ethernet_arch_lwip_end();
+    config.server = WiFi.localIP();
+#else
+    WiFi.hostByName(LOAD_SERVER_HOST, config.server);
+#endif
+
+    generator = new LoadGenerator(config);
+    ethernet_arch_lwip_begin();
+    generator->start();
+    ethernet_arch_lwip_end();
+    Serial1.printf("[load] mode=%d conns=%d size=%d think=%dms\n",
+                   static_cast<int>(config.mode), LOAD_CONNECTIONS,
+                   LOAD_MESSAGE_SIZE, LOAD_THINK_MS);
+}
+
+void loop() {
+    static bool done = false;
+    if (done) {
+        delay(1000);
+        return;
+    }
+
+    ethernet_arch_lwip_begin();
+    const bool running = generator->poll();
+    ethernet_arch_lwip_end();
+
+    if (!running) {
+        LoadGenerator::print(generator->report(), Serial1);
+        done = true;
+    }
+}
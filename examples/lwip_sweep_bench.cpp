@@ -0,0 +1,224 @@
+/*
+ * lwIP option sweep benchmark: runs the standard workloads once and prints
+ * one machine-readable SWEEP line per workload for tools/lwip_sweep.py.
+ *
+ *  - rx:   chargen into IoRxBuffer, throughput
+ *  - tx:   TcpWriter into discard, throughput
+ *  - echo: request/response through both, latency percentiles
+ *
+ * Memory is reported as the static lwIP footprint (memp pools plus
+ * MEM_SIZE, i.e. what the options cost up front) and the peaks reached
+ * during the run: heap in use and memp elements in bytes. Peaks need
+ * LWIP_STATS=1 and MEMP_STATS=1; without them they read as zero.
+ *
+ * The workloads run against LoadServers on this board (loopback, needs
+ * LWIP_NETIF_LOOPBACK=1) unless SWEEP_SERVER_HOST is defined, in which
+ * case an external discard/chargen/echo server is used.
+ *
+ * Arduino-Pico links a precompiled lwIP, so -D options given to the sketch
+ * do not necessarily reach it. wnd, snd_buf, pbuf_pool and tcp_seg are
+ * therefore read back at runtime (from a fresh PCB and memp_pools), and
+ * lwip_match=0 flags a build whose lwIP does not use the requested values.
+ * TCP_MSS cannot be read back; the mss column is only meaningful with an
+ * lwIP rebuilt from the same options.
+ */
+#include "LoadGenerator.hpp"
+#include "LoadServers.hpp"
+#include "secrets.h" // WIFI_SSID, WIFI_PASSWORD[, SWEEP_SERVER_HOST]
+
+#include <Arduino.h>
+#include <LwipEthernet.h>
+#include <WiFi.h>
+#include <lwip/memp.h>
+#include <lwip/priv/memp_priv.h>
+#include <lwip/stats.h>
+#include <malloc.h>
+
+#ifndef SWEEP_RUN_MS
+#define SWEEP_RUN_MS 10000
+#endif
+#ifndef SWEEP_CONNECTIONS
+#define SWEEP_CONNECTIONS 2
+#endif
+#ifndef SWEEP_MESSAGE_SIZE
+#define SWEEP_MESSAGE_SIZE 1024
+#endif
+#ifndef SWEEP_ECHO_SIZE
+#define SWEEP_ECHO_SIZE 128
+#endif
+
+using namespace async_tcp;
+
+namespace {
+
+    struct Workload {
+            const char *name;
+            LoadGenerator::Mode mode;
+            uint16_t port;
+            uint32_t message_size;
+    };
+
+    const Workload workloads[] = {
+        {"rx", LoadGenerator::Mode::Chargen, LoadServers::CHARGEN_PORT, 0},
+        {"tx", LoadGenerator::Mode::Discard, LoadServers::DISCARD_PORT,
+         SWEEP_MESSAGE_SIZE},
+        {"echo", LoadGenerator::Mode::Echo, LoadServers::ECHO_PORT,
+         SWEEP_ECHO_SIZE},
+    };
+
+    LoadServers servers;
+    IPAddress server_ip;
+    LoadGenerator *generator = nullptr;
+    std::size_t current = 0;
+    uint32_t heap_peak = 0;
+
+    /// Options as compiled into the linked lwIP.
+    struct Effective {
+            uint32_t wnd = TCP_WND;
+            uint32_t snd_buf = TCP_SND_BUF;
+            uint32_t pbuf_pool = PBUF_POOL_SIZE;
+            uint32_t tcp_seg = MEMP_NUM_TCP_SEG;
+    } effective;
+
+    // Call with the lwIP lock held.
+    void readEffective() {
+        if (tcp_pcb *pcb = tcp_new()) {
+            effective.wnd = pcb->rcv_wnd;
+            effective.snd_buf = tcp_sndbuf(pcb);
+            tcp_close(pcb);
+        }
+#if !MEMP_MEM_MALLOC
+        effective.pbuf_pool = memp_pools[MEMP_PBUF_POOL]->num;
+        effective.tcp_seg = memp_pools[MEMP_TCP_SEG]->num;
+#endif
+    }
+
+    bool effectiveMatches() {
+        return effective.wnd == TCPWND_MIN16(TCP_WND) &&
+               effective.snd_buf == TCP_SND_BUF &&
+               effective.pbuf_pool == PBUF_POOL_SIZE &&
+               effective.tcp_seg == MEMP_NUM_TCP_SEG;
+    }
+
+    uint32_t staticBytes() {
+        uint32_t bytes = MEM_SIZE;
+#if !MEMP_MEM_MALLOC
+        for (int i = 0; i < MEMP_MAX; ++i) {
+            bytes += static_cast<uint32_t>(memp_pools[i]->num) *
+                     memp_pools[i]->size;
+        }
+#endif
+        return bytes;
+    }
+
+    uint32_t mempPeakBytes() {
+        uint32_t bytes = 0;
+#if LWIP_STATS && MEMP_STATS
+        for (int i = 0; i < MEMP_MAX; ++i) {
+            if (lwip_stats.memp[i]) {
+                bytes += static_cast<uint32_t>(lwip_stats.memp[i]->max) *
+                         memp_pools[i]->size;
+            }
+        }
+#endif
+        return bytes;
+    }
+
+    void resetPeaks() {
+#if LWIP_STATS && MEMP_STATS
+        for (int i = 0; i < MEMP_MAX; ++i) {
+            if (lwip_stats.memp[i]) {
+                lwip_stats.memp[i]->max = lwip_stats.memp[i]->used;
+            }
+        }
+#endif
+        heap_peak = static_cast<uint32_t>(mallinfo().uordblks);
+    }
+
+    void startWorkload(const Workload &w) {
+        LoadGenerator::Config config;
+        config.server = server_ip;
+        config.port = w.port;
+        config.mode = w.mode;
+        config.connections = SWEEP_CONNECTIONS;
+        config.message_size = w.message_size;
+        config.duration_ms = SWEEP_RUN_MS;
+
+        generator = new LoadGenerator(config);
+        resetPeaks();
+        ethernet_arch_lwip_begin();
+        generator->start();
+        ethernet_arch_lwip_end();
+    }
+
+    void printResult(const Workload &w, const LoadGenerator::Report &r) {
+        // Key=value pairs, one line per workload; parsed by lwip_sweep.py.
+        Serial1.printf("SWEEP workload=%s mss=%d wnd=%d snd_buf=%d "
+                       "pbuf_pool=%d tcp_seg=%d mbps=%.3f p50_us=%lu "
+                       "p99_us=%lu errors=%lu static_bytes=%lu "
+                       "heap_peak=%lu memp_peak=%lu lwip_match=%d\n",
+                       w.name, TCP_MSS, static_cast<int>(effective.wnd),
+                       static_cast<int>(effective.snd_buf),
+                       static_cast<int>(effective.pbuf_pool),
+                       static_cast<int>(effective.tcp_seg),
+                       static_cast<double>(r.mb_per_s),
+                       static_cast<unsigned long>(r.latency_p50_us),
+                       static_cast<unsigned long>(r.latency_p99_us),
+                       static_cast<unsigned long>(r.errors +
+                                                  r.connect_failures),
+                       static_cast<unsigned long>(staticBytes()),
+                       static_cast<unsigned long>(heap_peak),
+                       static_cast<unsigned long>(mempPeakBytes()),
+                       effectiveMatches() ? 1 : 0);
+    }
+
+} // namespace
+
+void setup() {
+    Serial1.begin(115200);
+    WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+    while (WiFi.status() != WL_CONNECTED) {
+        delay(100);
+    }
+
+    ethernet_arch_lwip_begin();
+    readEffective();
+    ethernet_arch_lwip_end();
+
+#ifdef SWEEP_SERVER_HOST
+    WiFi.hostByName(SWEEP_SERVER_HOST, server_ip);
+#else
+    ethernet_arch_lwip_begin();
+    servers.beginAll();
+    ethernet_arch_lwip_end();
+    server_ip = WiFi.localIP();
+#endif
+
+    startWorkload(workloads[current]);
+}
+
+void loop() {
+    if (!generator) {
+        delay(1000);
+        return;
+    }
+
+    ethernet_arch_lwip_begin();
+    const bool running = generator->poll();
+    ethernet_arch_lwip_end();
+    heap_peak = std::max(heap_peak,
+                         static_cast<uint32_t>(mallinfo().uordblks));
+    if (running) {
+        return;
+    }
+
+    printResult(workloads[current], generator->report());
+    delete generator;
+    generator = nullptr;
+
+    if (++current < sizeof(workloads) / sizeof(workloads[0])) {
+        startWorkload(workloads[current]);
+    } else {
+        Serial1.printf("SWEEP done\n");
+    }
+}
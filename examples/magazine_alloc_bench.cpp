@@ -0,0 +1,158 @@
+/*
+ * Cross-core allocation: heap vs. MagazineAllocator.
+ *
+ * Core 0 allocates BENCH_OPS payload-sized messages (the size of an
+ * AccessorPayload) and passes them to core 1 through a BytePipe; core 1
+ * frees them, as the networking core does with accessor payloads. Every
+ * BENCH_KEEP_EVERY-th message is kept until the end, and a small
+ * variable-size heap allocation is made per message, to model the
+ * long-lived application allocations that short-lived blocks fragment
+ * around.
+ *
+ * The same run is made once with plain new/delete and once with a
+ * MagazineAllocated message type. Each prints average alloc and free time
+ * per message (measured over batches of BENCH_BATCH) and the heap before
+ * and after:
+ *
+ *   MAGBENCH alloc=heap alloc_ns=.. free_ns=.. free_heap=.. largest=..
+ *            frag_pct=..
+ *
+ * frag_pct is 100 - largest free block * 100 / free heap.
+ */
+#include "BytePipe.hpp"
+#include "MagazineAllocator.hpp"
+#include "SoakMonitor.hpp"
+
+#include <Arduino.h>
+#include <atomic>
+#include <pico/time.h>
+
+#ifndef BENCH_OPS
+#define BENCH_OPS 20000
+#endif
+#ifndef BENCH_BATCH
+#define BENCH_BATCH 16
+#endif
+#ifndef BENCH_KEEP_EVERY
+#define BENCH_KEEP_EVERY 64
+#endif
+
+using namespace async_tcp;
+
+namespace {
+
+    struct HeapMsg {
+            virtual ~HeapMsg() = default;
+            uint8_t data[20];
+    };
+
+    struct MagMsg final : HeapMsg, MagazineAllocated {};
+
+    constexpr std::size_t KEPT = BENCH_OPS / BENCH_KEEP_EVERY + 1;
+
+    uint8_t pipe_storage[256];
+    BytePipe pipe(pipe_storage, sizeof(pipe_storage));
+    HeapMsg *kept[KEPT];
+    void *app_blocks[KEPT];
+
+    std::atomic<uint32_t> freed{0};
+    std::atomic<uint64_t> free_us{0};
+
+    struct Result {
+            uint32_t alloc_ns;
+            uint32_t free_ns;
+            uint32_t free_heap;
+            uint32_t largest;
+    };
+
+    template <typename Msg> Result run() {
+        freed.store(0);
+        free_us.store(0);
+        std::size_t n_kept = 0;
+        uint64_t alloc_us = 0;
+        HeapMsg *batch[BENCH_BATCH];
+
+        for (uint32_t done = 0; done < BENCH_OPS; done += BENCH_BATCH) {
+            const uint32_t t0 = time_us_32();
+            for (auto &m : batch) {
+                m = new Msg;
+            }
+            alloc_us += time_us_32() - t0;
+
+            for (std::size_t i = 0; i < BENCH_BATCH; ++i) {
+                if ((done + i) % BENCH_KEEP_EVERY == 0 && n_kept < KEPT) {
+                    app_blocks[n_kept] = malloc(24 + (done + i) % 200);
+                    kept[n_kept++] = batch[i];
+                    continue;
+                }
+                while (!pipe.waitWritable(sizeof(HeapMsg *), 1000)) {
+                }
+                pipe.write(reinterpret_cast<const uint8_t *>(&batch[i]),
+                           sizeof(HeapMsg *));
+            }
+        }
+        while (freed.load() + n_kept < BENCH_OPS) {
+            tight_loop_contents();
+        }
+
+        Result r{};
+        r.alloc_ns = static_cast<uint32_t>(alloc_us * 1000 / BENCH_OPS);
+        r.free_ns = static_cast<uint32_t>(free_us.load() * 1000 /
+                                          (BENCH_OPS - n_kept));
+        r.free_heap = static_cast<uint32_t>(rp2040.getFreeHeap());
+        r.largest = SoakMonitor::largestFreeBlock();
+
+        for (std::size_t i = 0; i < n_kept; ++i) {
+            delete kept[i];
+            free(app_blocks[i]);
+        }
+        return r;
+    }
+
+    void report(const char *name, const Result &r) {
+        const unsigned long frag =
+            r.free_heap ? 100 - static_cast<uint64_t>(r.largest) * 100 /
+                                    r.free_heap
+                        : 0;
+        Serial1.printf("MAGBENCH alloc=%s alloc_ns=%lu free_ns=%lu "
+                       "free_heap=%lu largest=%lu frag_pct=%lu\n",
+                       name, static_cast<unsigned long>(r.alloc_ns),
+                       static_cast<unsigned long>(r.free_ns),
+                       static_cast<unsigned long>(r.free_heap),
+                       static_cast<unsigned long>(r.largest), frag);
+    }
+
+} // namespace
+
+void setup() {
+    Serial1.begin(115200);
+    delay(1000);
+
+    Result base{};
+    base.free_heap = static_cast<uint32_t>(rp2040.getFreeHeap());
+    base.largest = SoakMonitor::largestFreeBlock();
+    report("none", base);
+
+    report("heap", run<HeapMsg>());
+    report("magazine", run<MagMsg>());
+    MagazineAllocator::print(Serial1);
+}
+
+void loop() { delay(1000); }
+
+void loop1() {
+    // Free in batches so the timer resolution does not dominate.
+    HeapMsg *batch[BENCH_BATCH];
+    const std::size_t bytes = pipe.read(reinterpret_cast<uint8_t *>(batch),
+                                        sizeof(batch));
+    const std::size_t n = bytes / sizeof(HeapMsg *);
+    if (n == 0) {
+        return;
+    }
+    const uint32_t t0 = time_us_32();
+    for (std::size_t i = 0; i < n; ++i) {
+        delete batch[i];
+    }
+    free_us.fetch_add(time_us_32() - t0);
+    freed.fetch_add(static_cast<uint32_t>(n));
+}
@@ -0,0 +1,207 @@
+/*
+ * PointerMap vs. TaskRegistry-style linked list at 8..256 entries.
+ *
+ * The list is the fixed-size, pointer-keyed singly linked list described
+ * in examples/README.md (node pool plus free list, insert at head, linear
+ * search). The map is PointerMap with twice the entry count as capacity.
+ * For each size the sketch measures:
+ *
+ *  - find:  lookups of random present keys,
+ *  - churn: the SerialPrinter pattern, one remove (oldest handler done)
+ *           plus one add per message at steady occupancy,
+ *
+ * and prints one line per size:
+ *
+ *   BENCH n=64 list_find_ns=... map_find_ns=... list_churn_ns=...
+ *         map_churn_ns=...
+ *
+ * Before that it checks erase() on a completely full map, whose cluster
+ * wraps around to the erased slot, for every slot (BENCH full=ok|FAIL).
+ *
+ * Runs once on core 0 with interrupts left on; repeat to gauge noise.
+ */
+#include "PointerMap.hpp"
+
+#include <Arduino.h>
+#include <pico/time.h>
+
+#ifndef BENCH_LOOKUPS
+#define BENCH_LOOKUPS 20000
+#endif
+#ifndef BENCH_CHURN
+#define BENCH_CHURN 5000
+#endif
+
+using namespace async_tcp;
+
+namespace {
+
+    constexpr std::size_t MAX_ENTRIES = 256;
+
+    struct Handler {
+            uint32_t payload[4];
+    };
+
+    Handler handlers[MAX_ENTRIES];
+    volatile uintptr_t sink = 0;
+    uint32_t rng = 0x12345678;
+
+    uint32_t next() {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        return rng;
+    }
+
+    template <std::size_t N> class ListRegistry {
+        public:
+            ListRegistry() {
+                for (std::size_t i = 0; i + 1 < N; ++i) {
+                    m_nodes[i].next = &m_nodes[i + 1];
+                }
+                m_free = &m_nodes[0];
+            }
+
+            bool add(const void *key, void *value) {
+                Node *n = m_free;
+                if (!n) {
+                    return false;
+                }
+                m_free = n->next;
+                n->key = key;
+                n->value = value;
+                n->next = m_head;
+                m_head = n;
+                return true;
+            }
+
+            void *find(const void *key) const {
+                for (Node *n = m_head; n; n = n->next) {
+                    if (n->key == key) {
+                        return n->value;
+                    }
+                }
+                return nullptr;
+            }
+
+            bool remove(const void *key) {
+                for (Node **p = &m_head; *p; p = &(*p)->next) {
+                    if ((*p)->key == key) {
+                        Node *n = *p;
+                        *p = n->next;
+                        n->next = m_free;
+                        m_free = n;
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+        private:
+            struct Node {
+                    const void *key = nullptr;
+                    void *value = nullptr;
+                    Node *next = nullptr;
+            };
+
+            Node m_nodes[N]{};
+            Node *m_head = nullptr;
+            Node *m_free = nullptr;
+    };
+
+    bool checkFull() {
+        constexpr std::size_t N = 16;
+        for (std::size_t victim = 0; victim < N; ++victim) {
+            PointerMap<void *, N> map;
+            for (std::size_t i = 0; i < N; ++i) {
+                map.insert(&handlers[i], &handlers[i]);
+            }
+            if (map.size() != N || map.insert(&handlers[N], nullptr) ||
+                !map.erase(&handlers[victim])) {
+                return false;
+            }
+            for (std::size_t i = 0; i < N; ++i) {
+                void **v = map.find(&handlers[i]);
+                if (i == victim ? v != nullptr : !v || *v != &handlers[i]) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    template <std::size_t N> void bench() {
+        static ListRegistry<N> list;
+        static PointerMap<void *, 2 * N> map;
+
+        for (std::size_t i = 0; i < N; ++i) {
+            list.add(&handlers[i], &handlers[i]);
+            map.insert(&handlers[i], &handlers[i]);
+        }
+
+        uint32_t t = time_us_32();
+        for (uint32_t i = 0; i < BENCH_LOOKUPS; ++i) {
+            sink = sink + reinterpret_cast<uintptr_t>(
+                              list.find(&handlers[next() % N]));
+        }
+        const uint32_t list_find = time_us_32() - t;
+
+        t = time_us_32();
+        for (uint32_t i = 0; i < BENCH_LOOKUPS; ++i) {
+            sink = sink + reinterpret_cast<uintptr_t>(
+                              *map.find(&handlers[next() % N]));
+        }
+        const uint32_t map_find = time_us_32() - t;
+
+        // One message: the oldest handler completes and is removed, the
+        // new message's handler is registered (FIFO, like print jobs).
+        t = time_us_32();
+        for (uint32_t i = 0; i < BENCH_CHURN; ++i) {
+            const void *key = &handlers[i % N];
+            list.remove(key);
+            list.add(key, nullptr);
+        }
+        const uint32_t list_churn = time_us_32() - t;
+
+        t = time_us_32();
+        for (uint32_t i = 0; i < BENCH_CHURN; ++i) {
+            const void *key = &handlers[i % N];
+            map.erase(key);
+            map.insert(key, nullptr);
+        }
+        const uint32_t map_churn = time_us_32() - t;
+
+        for (std::size_t i = 0; i < N; ++i) {
+            list.remove(&handlers[i]);
+            map.erase(&handlers[i]);
+        }
+
+        Serial1.printf("BENCH n=%u list_find_ns=%lu map_find_ns=%lu "
+                       "list_churn_ns=%lu map_churn_ns=%lu\n",
+                       static_cast<unsigned>(N),
+                       static_cast<unsigned long>(list_find * 1000ULL /
+                                                  BENCH_LOOKUPS),
+                       static_cast<unsigned long>(map_find * 1000ULL /
+                                                  BENCH_LOOKUPS),
+                       static_cast<unsigned long>(list_churn * 1000ULL /
+                                                  BENCH_CHURN),
+                       static_cast<unsigned long>(map_churn * 1000ULL /
+                                                  BENCH_CHURN));
+    }
+
+} // namespace
+
+void setup() {
+    Serial1.begin(115200);
+    delay(2000);
+    Serial1.printf("BENCH full=%s\n", checkFull() ? "ok" : "FAIL");
+    bench<8>();
+    bench<16>();
+    bench<32>();
+    bench<64>();
+    bench<128>();
+    bench<256>();
+    Serial1.printf("BENCH done\n");
+}
+
+void loop() { delay(1000); }
@@ -0,0 +1,199 @@
+/*
+ * Soak test: SOAK_CLIENTS connections churn through connect -> echo transfer
+ * -> close against an echo server for SOAK_DURATION_MS, while SoakMonitor
+ * samples heap usage, the largest free block, lwIP memp usage and
+ * throughput every SOAK_SAMPLE_MS. The run stops with a FAIL line as soon
+ * as one of them drifts beyond its limit.
+ *
+ * Every cycle allocates and frees a TcpClientContext (with its IoRxBuffer
+ * and TcpWriter) and a PCB, which is the per-connection churn that leaks
+ * and fragments in long-running deployments.
+ *
+ * Build with LWIP_STATS=1 and MEMP_STATS=1 to get memp figures.
+ */
+#include "SoakMonitor.hpp"
+#include "TcpClientContext.hpp"
+#include "secrets.h" // WIFI_SSID, WIFI_PASSWORD, ECHO_HOST, ECHO_PORT
+
+#include <Arduino.h>
+#include <LwipEthernet.h>
+#include <WiFi.h>
+
+#ifndef SOAK_CLIENTS
+#define SOAK_CLIENTS 16
+#endif
+#ifndef SOAK_TRANSFER_BYTES
+#define SOAK_TRANSFER_BYTES 4096
+#endif
+#ifndef SOAK_SAMPLE_MS
+#define SOAK_SAMPLE_MS 60000
+#endif
+#ifndef SOAK_DURATION_MS
+#define SOAK_DURATION_MS (12UL * 3600UL * 1000UL)
+#endif
+
+using namespace async_tcp;
+
+namespace {
+
+    struct ChurnClient {
+            TcpClientContext *ctx = nullptr;
+            uint8_t id = 0;
+            std::size_t sent = 0;
+            volatile std::size_t echoed = 0;
+            volatile bool connected = false;
+            volatile bool finished = false;
+            volatile bool failed = false;
+    };
+
+    ChurnClient clients[SOAK_CLIENTS];
+    IPAddress echo_ip;
+    SoakMonitor monitor;
+
+    uint64_t bytes_total = 0;
+    uint32_t cycles = 0;
+    uint32_t failures = 0;
+    uint32_t mismatches = 0;
+
+    uint8_t pattern(const std::size_t offset) {
+        return static_cast<uint8_t>(offset * 31 + 7);
+    }
+
+    void onReceive(ChurnClient &c) {
+        auto *rx = c.ctx->getRxBuffer();
+        while (const auto n = rx->peekAvailable()) {
+            const auto *data = rx->peekBuffer();
+            for (std::size_t i = 0; i < n; ++i) {
+                if (static_cast<uint8_t>(data[i]) != pattern(c.echoed + i)) {
+                    ++mismatches;
+                    break;
+                }
+            }
+            c.echoed += n;
+            rx->peekConsume(n);
+        }
+        if (c.echoed >= SOAK_TRANSFER_BYTES) {
+            c.finished = true;
+        }
+    }
+
+    bool start(ChurnClient &c) {
+        tcp_pcb *pcb = tcp_new();
+        if (!pcb) {
+            return false;
+        }
+        c.ctx = new TcpClientContext(pcb);
+        c.ctx->setClientId(c.id);
+        c.sent = 0;
+        c.echoed = 0;
+        c.connected = false;
+        c.finished = false;
+        c.failed = false;
+
+        c.ctx->setOnConnectCallback([&c] { c.connected = true; });
+        c.ctx->setOnReceivedCallback([&c] { onReceive(c); });
+        c.ctx->setOnFinCallback([&c] { c.finished = true; });
+        c.ctx->setOnErrorCallback([&c](err_t) { c.failed = true; });
+
+        IPAddress addr = echo_ip; // connect() may assign an IPv6 zone
+        if (c.ctx->connect(addr, ECHO_PORT) != ERR_OK) {
+            delete c.ctx;
+            c.ctx = nullptr;
+            return false;
+        }
+        return true;
+    }
+
+    void finish(ChurnClient &c) {
+        // After tcp_err lwIP has already freed the PCB; only close healthy
+        // connections.
+        if (!c.failed) {
+            c.ctx->close();
+        }
+        delete c.ctx;
+        c.ctx = nullptr;
+        bytes_total += c.echoed;
+        ++cycles;
+    }
+
+    void pump(ChurnClient &c) {
+        if (!c.ctx) {
+            if (!start(c)) {
+                ++failures;
+            }
+            return;
+        }
+        if (c.failed || c.finished) {
+            failures += c.failed ? 1 : 0;
+            finish(c);
+            return;
+        }
+        if (!c.connected || c.sent >= SOAK_TRANSFER_BYTES) {
+            return;
+        }
+
+        uint8_t chunk[TCP_MSS];
+        auto *tx = c.ctx->getTxWriter();
+        const auto n = tx->getOptimalChunkSize(SOAK_TRANSFER_BYTES - c.sent);
+        for (std::size_t i = 0; i < n; ++i) {
+            chunk[i] = pattern(c.sent + i);
+        }
+        // chunk is gone when this returns: let lwIP copy it.
+        c.sent += tx->writeData(chunk, n, true);
+    }
+
+} // namespace
+
+void setup() {
+    Serial1.begin(115200);
+    WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+    while (WiFi.status() != WL_CONNECTED) {
+        delay(100);
+    }
+    WiFi.hostByName(ECHO_HOST, echo_ip);
+
+    for (uint8_t i = 0; i < SOAK_CLIENTS; ++i) {
+        clients[i].id = i;
+    }
+    monitor.sample(0);
+    Serial1.printf("[soak] %d clients, %d bytes per cycle\n", SOAK_CLIENTS,
+                   SOAK_TRANSFER_BYTES);
+}
+
+void loop() {
+    static uint32_t started = millis();
+    static uint32_t last_sample = started;
+    static bool stopped = false;
+
+    if (stopped) {
+        delay(1000);
+        return;
+    }
+
+    // loop() is not the networking context: take the lwIP lock.
+    ethernet_arch_lwip_begin();
+    for (auto &c : clients) {
+        pump(c);
+    }
+    ethernet_arch_lwip_end();
+
+    if (millis() - last_sample < SOAK_SAMPLE_MS) {
+        return;
+    }
+    last_sample = millis();
+
+    monitor.sample(bytes_total);
+    monitor.report(Serial1);
+    Serial1.printf("[soak] cycles=%lu failures=%lu mismatches=%lu\n",
+                   static_cast<unsigned long>(cycles),
+                   static_cast<unsigned long>(failures),
+                   static_cast<unsigned long>(mismatches));
+
+    if (!monitor.healthy() || mismatches) {
+        Serial1.printf("[soak] FAIL\n");
+        stopped = true;
+    } else if (millis() - started >= SOAK_DURATION_MS) {
+        Serial1.printf("[soak] PASS\n");
+        stopped = true;
+    }
+}
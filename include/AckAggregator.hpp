@@ -0,0 +1,113 @@
+/**
+ * @file AckAggregator.hpp
+ * @brief Batched ACK notifications for TcpClient.
+ *
+ * Every lwIP sent callback normally runs the client's ACK bridge (or
+ * scheduled handler) with the few hundred bytes it acknowledged; during a
+ * bulk transfer that is hundreds of dispatches per second. With an
+ * AckAggregator attached, TcpClient::_onAckCallback() only adds the byte
+ * count to the client's pending total and the aggregator delivers one
+ * notification carrying the sum when
+ *
+ *  - the pending total reaches Config::flush_bytes, or
+ *  - Config::max_delay_us have passed since the first unnotified ACK, or,
+ *    with max_delay_us = 0, at the end of the current async_context
+ *    dispatch cycle.
+ *
+ * Accounting stays exact: each ACKed byte is reported once, either in a
+ * notification or by TcpClient::takeAckedBytes(), which any core may call
+ * to collect the pending total without waiting for the flush. Writability
+ * and the completion queue are still updated on every ACK.
+ *
+ * One aggregator serves up to ASYNC_TCP_ACK_CLIENTS clients with pending
+ * bytes at a time; when that is exceeded the ACK is delivered right away.
+ * add() and flush() run on the networking core with the async context
+ * lock held (lwIP callbacks and workers do); cancel() takes the lock.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <cstdint>
+#include <lwip/opt.h>
+#include <pico/async_context.h>
+
+#ifndef ASYNC_TCP_ACK_CLIENTS
+#define ASYNC_TCP_ACK_CLIENTS 32 // clients with pending ACKs
+#endif
+
+namespace async_tcp {
+
+    class TcpClient;
+
+    class AckAggregator {
+        public:
+            struct Config {
+                    /// Notify once this many bytes are pending (<= 65535,
+                    /// the ACK bridge payload is a uint16_t).
+                    uint32_t flush_bytes = 4 * TCP_MSS;
+                    /// Longest hold of an ACK; 0 = end of dispatch cycle.
+                    uint32_t max_delay_us = 2000;
+            };
+
+            struct Stats {
+                    uint32_t acks = 0;          ///< lwIP sent callbacks
+                    uint32_t notifications = 0; ///< Deliveries to the client
+                    uint32_t overflows = 0;     ///< Delivered unbatched
+                    uint64_t bytes = 0;
+            };
+
+            /**
+             * @param ctx The networking async context.
+             */
+            explicit AckAggregator(async_context_t *ctx,
+                                   const Config &config = Config{});
+            ~AckAggregator();
+
+            AckAggregator(const AckAggregator &) = delete;
+            AckAggregator &operator=(const AckAggregator &) = delete;
+
+            /**
+             * @brief Account @p len ACKed bytes of @p client.
+             */
+            void add(TcpClient &client, uint16_t len);
+
+            /**
+             * @brief Deliver every pending total now.
+             */
+            void flush();
+
+            /**
+             * @brief Forget @p client; its pending bytes stay available to
+             * takeAckedBytes().
+             */
+            void cancel(TcpClient &client);
+
+            [[nodiscard]] Stats stats() const;
+
+            void resetStats();
+
+            void print(Print &out) const;
+
+        private:
+            static void s_flush_at(async_context_t *ctx,
+                                   async_at_time_worker_t *worker);
+            static void s_flush_pending(async_context_t *ctx,
+                                        async_when_pending_worker_t *worker);
+
+            void arm();
+            void deliver(TcpClient &client);
+
+            async_context_t *m_ctx;
+            Config m_config;
+            async_at_time_worker_t m_timer{};
+            async_when_pending_worker_t m_cycle{};
+            TcpClient *m_dirty[ASYNC_TCP_ACK_CLIENTS]{};
+            uint8_t m_count = 0;
+            TcpClient **m_flushing = nullptr; ///< flush()'s copy, while it runs
+            uint8_t m_flush_count = 0;
+            bool m_armed = false;
+            Stats m_stats{};
+    };
+
+} // namespace async_tcp
@@ -0,0 +1,95 @@
+/**
+ * @file AdaptiveNagle.hpp
+ * @brief Per-connection Nagle on/off decisions from observed write patterns.
+ *
+ * Connections that alternate between interactive bursts and bulk streaming
+ * want no-delay for the former and coalescing for the latter. AdaptiveNagle
+ * keeps an exponentially weighted moving average (EWMA, weight 1/8) of the
+ * write size and of the gap between writes. A write counts as bulk when
+ * the average size is at least Config::bulk_bytes and the average gap
+ * below Config::bulk_gap_us, otherwise as interactive.
+ *
+ * Hysteresis: coalescing turns on after enter_bulk bulk writes in a row and
+ * off again after exit_bulk interactive writes in a row, so a single odd
+ * write does not flip the PCB flag. Every switch is kept in a small ring
+ * (history()) with the averages that caused it, for tuning the thresholds.
+ *
+ * TcpWriter::writeData() and TcpClientContext::writeChunk() call observe()
+ * on the networking core before queueing and apply the result with
+ * tcp_nagle_enable()/disable().
+ * Attach it with TcpClient::enableAdaptiveNoDelay().
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <cstddef>
+#include <cstdint>
+#include <lwip/opt.h>
+
+#ifndef ASYNC_TCP_NAGLE_HISTORY
+#define ASYNC_TCP_NAGLE_HISTORY 16 // mode switches kept
+#endif
+
+namespace async_tcp {
+
+    class AdaptiveNagle {
+        public:
+            struct Config {
+                    uint32_t bulk_bytes = TCP_MSS / 2; ///< Average size for bulk
+                    uint32_t bulk_gap_us = 2000;       ///< Average gap for bulk
+                    uint8_t enter_bulk = 4; ///< Bulk writes in a row to coalesce
+                    uint8_t exit_bulk = 2;  ///< Small writes in a row to stop
+            };
+
+            struct Decision {
+                    uint32_t t_us;       ///< time_us_32() of the switch
+                    uint32_t avg_bytes;  ///< Size EWMA at the switch
+                    uint32_t avg_gap_us; ///< Gap EWMA at the switch
+                    bool coalesce;       ///< New mode: true = Nagle on
+            };
+
+            AdaptiveNagle() = default;
+            explicit AdaptiveNagle(const Config &config) : m_config(config) {}
+
+            /**
+             * @brief Account one write of @p bytes at @p t_us.
+             * @return true if Nagle should be enabled for it.
+             */
+            bool observe(std::size_t bytes, uint32_t t_us);
+
+            [[nodiscard]] bool coalescing() const { return m_coalesce; }
+
+            [[nodiscard]] uint32_t averageBytes() const {
+                return m_avg_bytes >> SHIFT;
+            }
+
+            [[nodiscard]] uint32_t averageGapUs() const {
+                return m_avg_gap >> SHIFT;
+            }
+
+            /**
+             * @brief The @p i-th most recent switch (0 = newest).
+             * @return false if fewer switches were recorded.
+             */
+            bool history(std::size_t i, Decision &out) const;
+
+            [[nodiscard]] uint32_t switches() const { return m_switches; }
+
+            void print(Print &out) const;
+
+        private:
+            static constexpr uint8_t SHIFT = 3; // EWMA weight 1/8
+
+            Config m_config{};
+            uint32_t m_avg_bytes = 0; ///< Scaled by 2^SHIFT
+            uint32_t m_avg_gap = 0;   ///< Scaled by 2^SHIFT
+            uint32_t m_last_us = 0;
+            bool m_seen = false;
+            bool m_coalesce = false;
+            uint8_t m_streak = 0; ///< Writes in a row pointing the other way
+            uint32_t m_switches = 0;
+            Decision m_history[ASYNC_TCP_NAGLE_HISTORY]{};
+    };
+
+} // namespace async_tcp
@@ -0,0 +1,154 @@
+/**
+ * @file BytePipe.hpp
+ * @brief Wait-free single-producer/single-consumer byte pipe between cores.
+ *
+ * A SyncBridge-guarded std::string (QuoteBuffer in the examples) costs a
+ * heap-allocated payload and an execute_sync round trip per operation, and
+ * get() copies the whole string. BytePipe is a fixed ring over caller
+ * storage (power-of-two size) with one writer and one reader, each on any
+ * core:
+ *
+ *  - Two-phase on both ends: the producer reserves free space, fills it in
+ *    place (e.g. straight from an IoRxBuffer) and commits; the consumer
+ *    peeks readable data, uses it in place (e.g. tcp_write()) and
+ *    releases. Data is copied once, by whoever fills the reservation.
+ *  - Both sides see the ring as up to two spans, so wraparound never needs
+ *    a bounce buffer.
+ *  - Doorbells: commits issue __sev() for waitReadable()/waitWritable()
+ *    and can mark an async_context when-pending worker pending, so a
+ *    consumer on the networking core runs as soon as data arrives.
+ *
+ * Head and tail are free-running words written by one side each, as in
+ * CompletionQueue; no lock and no read-modify-write is needed.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <pico/async_context.h>
+
+namespace async_tcp {
+
+    class BytePipe {
+        public:
+            struct Span {
+                    uint8_t *data;
+                    std::size_t size;
+            };
+
+            /// A region of the ring; second is empty unless it wraps.
+            struct Spans {
+                    Span first;
+                    Span second;
+
+                    [[nodiscard]] std::size_t size() const {
+                        return first.size + second.size;
+                    }
+            };
+
+            /**
+             * @param storage Ring memory, alive as long as the pipe.
+             * @param capacity Size of @p storage, a power of two.
+             */
+            BytePipe(uint8_t *storage, std::size_t capacity);
+
+            BytePipe(const BytePipe &) = delete;
+            BytePipe &operator=(const BytePipe &) = delete;
+
+            // --- Producer side ---
+
+            /**
+             * @brief Free space, at most @p max bytes, to fill in place.
+             */
+            [[nodiscard]] Spans reserve(std::size_t max = SIZE_MAX) const;
+
+            /**
+             * @brief Publish @p n bytes of the last reservation.
+             */
+            void commit(std::size_t n);
+
+            /**
+             * @brief Copy up to @p size bytes in and commit them.
+             * @return Bytes written; less than @p size when full.
+             */
+            std::size_t write(const uint8_t *data, std::size_t size);
+
+            // --- Consumer side ---
+
+            /**
+             * @brief Readable data, at most @p max bytes, to use in place.
+             */
+            [[nodiscard]] Spans peek(std::size_t max = SIZE_MAX) const;
+
+            /**
+             * @brief Hand @p n peeked bytes back to the producer.
+             */
+            void release(std::size_t n);
+
+            /**
+             * @brief Copy up to @p size bytes out and release them.
+             * @return Bytes read.
+             */
+            std::size_t read(uint8_t *out, std::size_t size);
+
+            // --- Either side ---
+
+            [[nodiscard]] std::size_t readable() const {
+                return m_head.load(std::memory_order_acquire) -
+                       m_tail.load(std::memory_order_acquire);
+            }
+
+            [[nodiscard]] std::size_t writable() const {
+                return m_capacity - readable();
+            }
+
+            [[nodiscard]] std::size_t capacity() const { return m_capacity; }
+
+            /**
+             * @brief Mark @p worker pending on @p ctx after every commit
+             * (data for the consumer); nullptr stops. Set before use.
+             */
+            void setReadDoorbell(async_context_t *ctx,
+                                 async_when_pending_worker_t *worker) {
+                m_read_ctx = ctx;
+                m_read_worker = worker;
+            }
+
+            /**
+             * @brief Mark @p worker pending on @p ctx after every release
+             * (space for the producer); nullptr stops. Set before use.
+             */
+            void setWriteDoorbell(async_context_t *ctx,
+                                  async_when_pending_worker_t *worker) {
+                m_write_ctx = ctx;
+                m_write_worker = worker;
+            }
+
+            /**
+             * @brief Sleep in __wfe() until @p min bytes are readable or
+             * @p timeout_us passes.
+             */
+            bool waitReadable(std::size_t min, uint32_t timeout_us) const;
+
+            /**
+             * @brief Sleep in __wfe() until @p min bytes are free or
+             * @p timeout_us passes.
+             */
+            bool waitWritable(std::size_t min, uint32_t timeout_us) const;
+
+        private:
+            [[nodiscard]] Spans spans(uint32_t pos, std::size_t n) const;
+
+            uint8_t *m_buf;
+            std::size_t m_capacity;
+            std::atomic<uint32_t> m_head{0}; ///< Written by the producer
+            std::atomic<uint32_t> m_tail{0}; ///< Written by the consumer
+            async_context_t *m_read_ctx = nullptr;
+            async_when_pending_worker_t *m_read_worker = nullptr;
+            async_context_t *m_write_ctx = nullptr;
+            async_when_pending_worker_t *m_write_worker = nullptr;
+    };
+
+} // namespace async_tcp
@@ -0,0 +1,119 @@
+/**
+ * @file CompletionQueue.hpp
+ * @brief Fixed-size SPSC ring of I/O completions for the application core.
+ *
+ * In completion-queue mode a TcpClient posts one Completion record per
+ * event (connect result, data readable, write ACKed, FIN, error) from the
+ * networking core instead of, or in addition to, running its
+ * PerpetualBridge handlers. The application core drains the queue in
+ * batches whenever it chooses, so application work never competes with
+ * lwIP on the networking core.
+ *
+ * Single producer (networking core), single consumer (application core).
+ * Head and tail are separate words written by one side each, so no lock
+ * and no read-modify-write is needed. When the ring is full a record is
+ * dropped and counted in overflows(); the consumer learns about it and
+ * can fall back to polling client state.
+ *
+ * post() issues __sev() so a consumer waiting in waitNonEmpty() wakes up.
+ *
+ * Records of clients attached to a HandleTable carry the connection's
+ * handle; HandleTable::isCurrent() tells the consumer whether the record
+ * still belongs to the live connection.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "HandleTable.hpp"
+
+#ifndef ASYNC_TCP_CQ_CAPACITY
+#define ASYNC_TCP_CQ_CAPACITY 64 // records, power of two
+#endif
+
+namespace async_tcp {
+
+    struct Completion {
+            enum class Type : uint8_t {
+                Connected = 1, ///< value: err_t of the connect
+                Readable,      ///< value: bytes appended to the RX buffer
+                WriteAcked,    ///< value: bytes ACKed by the peer
+                Fin,           ///< value: 0
+                Error          ///< value: err_t from tcp_err
+            };
+
+            uint32_t t_us;     ///< time_us_32() when posted
+            int32_t value;     ///< See Type
+            Type type;
+            uint8_t client_id;
+            uint16_t reserved;
+            ClientHandle handle; ///< HandleTable::INVALID when not attached
+    };
+
+    static_assert(sizeof(Completion) == 16, "Completion must stay compact");
+
+    class CompletionQueue {
+        public:
+            static constexpr std::size_t CAPACITY = ASYNC_TCP_CQ_CAPACITY;
+            static_assert((CAPACITY & (CAPACITY - 1)) == 0,
+                          "ASYNC_TCP_CQ_CAPACITY must be a power of two");
+
+            /**
+             * @brief Append a record (producer side).
+             * @return false if the ring was full and the record dropped.
+             */
+            bool post(Completion::Type type, uint8_t client_id, int32_t value,
+                      ClientHandle handle = HandleTable::INVALID);
+
+            /**
+             * @brief Move up to @p max records into @p out (consumer side).
+             * @return Number of records copied.
+             */
+            std::size_t drain(Completion *out, std::size_t max);
+
+            /**
+             * @brief Call @p fn for every queued record, oldest first, and
+             * release them in one step (consumer side).
+             */
+            template <typename F> std::size_t drain(F &&fn) {
+                const uint32_t tail = m_tail.load(std::memory_order_relaxed);
+                const uint32_t head = m_head.load(std::memory_order_acquire);
+                for (uint32_t i = tail; i != head; ++i) {
+                    fn(m_ring[i & (CAPACITY - 1)]);
+                }
+                m_tail.store(head, std::memory_order_release);
+                return head - tail;
+            }
+
+            [[nodiscard]] std::size_t size() const {
+                return m_head.load(std::memory_order_acquire) -
+                       m_tail.load(std::memory_order_acquire);
+            }
+
+            [[nodiscard]] bool empty() const { return size() == 0; }
+
+            /**
+             * @brief Records dropped because the ring was full.
+             */
+            [[nodiscard]] uint32_t overflows() const {
+                return m_overflows.load(std::memory_order_relaxed);
+            }
+
+            /**
+             * @brief Sleep in __wfe() until a record is queued or
+             * @p timeout_us passes (consumer side).
+             * @return true when the queue is non-empty.
+             */
+            bool waitNonEmpty(uint32_t timeout_us) const;
+
+        private:
+            Completion m_ring[CAPACITY]{};
+            std::atomic<uint32_t> m_head{0}; ///< Written by the producer
+            std::atomic<uint32_t> m_tail{0}; ///< Written by the consumer
+            std::atomic<uint32_t> m_overflows{0}; ///< Producer only
+    };
+
+} // namespace async_tcp
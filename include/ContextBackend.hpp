@@ -0,0 +1,120 @@
+/**
+ * @file ContextBackend.hpp
+ * @brief Selectable Pico SDK async_context backends.
+ *
+ * The library runs on an async_context_t; which implementation backs it is
+ * a deployment choice:
+ *
+ *  - ThreadsafeBackground: IRQ-driven work on the core that initialises it,
+ *    with a recursive lock for cross-core access (the library default).
+ *  - Poll: no IRQ and no background processing; the owning core calls
+ *    poll() or run() in a loop. Lowest event-to-handler latency when a core
+ *    can be dedicated to it.
+ *  - FreeRtos: a FreeRTOS task services the context; only available in
+ *    FreeRTOS SMP builds (__FREERTOS) that link
+ *    pico_async_context_freertos.
+ *
+ * ContextBackend owns storage for any of the three and hands out the
+ * generic async_context_t, so PriorityScheduler, ScheduledWriter and
+ * custom workers are backend-agnostic. The default comes from
+ * ASYNC_TCP_CONTEXT_BACKEND (0 = threadsafe_background, 1 = poll,
+ * 2 = FreeRTOS).
+ *
+ * init() binds the context to the calling core (FreeRTOS: to @p core when
+ * the kernel supports core affinity), so call it from the core that should
+ * run the handlers.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <pico/async_context.h>
+#include <pico/async_context_poll.h>
+#include <pico/async_context_threadsafe_background.h>
+
+#if defined(__FREERTOS) && __has_include(<pico/async_context_freertos.h>)
+#include <pico/async_context_freertos.h>
+#define ASYNC_TCP_HAS_FREERTOS_CONTEXT 1
+#else
+#define ASYNC_TCP_HAS_FREERTOS_CONTEXT 0
+#endif
+
+#ifndef ASYNC_TCP_CONTEXT_BACKEND
+#define ASYNC_TCP_CONTEXT_BACKEND 0
+#endif
+
+namespace async_tcp {
+
+    class ContextBackend {
+        public:
+            enum class Kind : uint8_t {
+                ThreadsafeBackground = 0,
+                Poll = 1,
+                FreeRtos = 2
+            };
+
+            static constexpr Kind DEFAULT =
+                static_cast<Kind>(ASYNC_TCP_CONTEXT_BACKEND);
+
+            static const char *name(Kind kind);
+
+            /**
+             * @brief Whether @p kind is compiled in.
+             */
+            static constexpr bool available(const Kind kind) {
+                return kind != Kind::FreeRtos || ASYNC_TCP_HAS_FREERTOS_CONTEXT;
+            }
+
+            ContextBackend() = default;
+            ~ContextBackend() { deinit(); }
+
+            ContextBackend(const ContextBackend &) = delete;
+            ContextBackend &operator=(const ContextBackend &) = delete;
+
+            /**
+             * @brief Initialise a @p kind context on the calling core.
+             * @param core FreeRTOS task core (ignored by the others).
+             * @return false if @p kind is unavailable or init failed.
+             */
+            bool init(Kind kind = DEFAULT, uint8_t core = 1);
+
+            void deinit();
+
+            /**
+             * @brief The initialised context, nullptr before init().
+             */
+            [[nodiscard]] async_context_t *context() {
+                return m_ready ? m_context : nullptr;
+            }
+
+            [[nodiscard]] Kind kind() const { return m_kind; }
+
+            /**
+             * @brief Service pending work once (Poll backend; a no-op for
+             * the others, which run on their own).
+             */
+            void poll();
+
+            /**
+             * @brief Poll until @p until, sleeping while no work is due
+             * (Poll backend; the others just sleep).
+             */
+            void run(absolute_time_t until);
+
+        private:
+            union Storage {
+                    async_context_threadsafe_background_t background;
+                    async_context_poll_t poll;
+#if ASYNC_TCP_HAS_FREERTOS_CONTEXT
+                    async_context_freertos_t freertos;
+#endif
+                    Storage() {}
+            };
+
+            Storage m_storage;
+            async_context_t *m_context = nullptr;
+            Kind m_kind = DEFAULT;
+            bool m_ready = false;
+    };
+
+} // namespace async_tcp
@@ -0,0 +1,134 @@
+/**
+ * @file EpochReclaimer.hpp
+ * @brief Epoch-based deferred reclamation for objects read across cores.
+ *
+ * A reader on either core wraps its accesses in a Guard, which announces
+ * the global epoch it started in. retire() stamps an object that has
+ * already been unpublished (no new reader can find it) with the current
+ * epoch and advances the epoch. collect() frees a retired object once no
+ * core is still inside a guard entered at or before that epoch, i.e. both
+ * cores have passed a quiescent point since it was unpublished.
+ *
+ * Guards are a couple of atomic stores and may nest. Deleters run from
+ * collect() (and from retire(), which collects first), outside the
+ * internal spin lock. Retiring a TcpClientContext frees pbufs, so call
+ * retire() and collect() with the lwIP lock held, e.g. from the
+ * networking core.
+ *
+ * An object retired while the other core is inside a Guard outlives that
+ * retire(). With setContext(), an at-time worker on the networking context
+ * runs collect() every ASYNC_TCP_EPOCH_COLLECT_MS while anything is
+ * pending; without it the application must call collect() periodically.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <hardware/sync.h>
+#include <pico/async_context.h>
+#include <pico/platform.h>
+
+#ifndef ASYNC_TCP_EPOCH_RETIRED
+#define ASYNC_TCP_EPOCH_RETIRED 16 // objects awaiting reclamation
+#endif
+#ifndef ASYNC_TCP_EPOCH_COLLECT_MS
+#define ASYNC_TCP_EPOCH_COLLECT_MS 10 // collect() period while pending
+#endif
+
+namespace async_tcp {
+
+    class EpochReclaimer {
+        public:
+            using Deleter = void (*)(void *);
+
+            /**
+             * @brief Read-side critical section on the calling core.
+             */
+            class Guard {
+                public:
+                    explicit Guard(EpochReclaimer &reclaimer)
+                        : m_reclaimer(reclaimer) {
+                        m_reclaimer.enter();
+                    }
+
+                    ~Guard() { m_reclaimer.exit(); }
+
+                    Guard(const Guard &) = delete;
+                    Guard &operator=(const Guard &) = delete;
+
+                private:
+                    EpochReclaimer &m_reclaimer;
+            };
+
+            struct Stats {
+                    uint32_t retired = 0;
+                    uint32_t freed = 0;
+                    uint32_t max_pending = 0;
+                    uint32_t stalls = 0; ///< retire() found the list full
+            };
+
+            EpochReclaimer();
+            ~EpochReclaimer();
+
+            EpochReclaimer(const EpochReclaimer &) = delete;
+            EpochReclaimer &operator=(const EpochReclaimer &) = delete;
+
+            /**
+             * @brief Free @p ptr with @p deleter once no reader can hold it.
+             * The caller must have unpublished @p ptr already. Spins on
+             * collect() while the retired list is full, so never call it
+             * inside a Guard.
+             */
+            void retire(void *ptr, Deleter deleter);
+
+            template <typename T> void retire(T *ptr) {
+                retire(ptr, [](void *p) { delete static_cast<T *>(p); });
+            }
+
+            /**
+             * @brief Free every retired object that is safe to free.
+             * @return Number of objects freed.
+             */
+            std::size_t collect();
+
+            [[nodiscard]] std::size_t pending() const { return m_count; }
+
+            /**
+             * @brief Drive collect() from an at-time worker on @p ctx (the
+             * networking context) while objects are pending; nullptr stops.
+             * Call with the lwIP lock held, before the first retire().
+             */
+            void setContext(async_context_t *ctx);
+
+            [[nodiscard]] const Stats &stats() const { return m_stats; }
+
+        private:
+            struct Retired {
+                    void *ptr;
+                    Deleter deleter;
+                    uint32_t epoch;
+            };
+
+            void enter();
+            void exit();
+            [[nodiscard]] bool reclaimable(uint32_t epoch) const;
+            void arm();
+
+            static void s_do_work(async_context_t *ctx,
+                                  async_at_time_worker_t *worker);
+
+            std::atomic<uint32_t> m_epoch{1};
+            std::atomic<uint32_t> m_active[NUM_CORES]{}; ///< 0 = quiescent
+            uint8_t m_depth[NUM_CORES]{};                 ///< Guard nesting
+            Retired m_retired[ASYNC_TCP_EPOCH_RETIRED]{};
+            std::size_t m_count = 0;
+            spin_lock_t *m_lock = nullptr;
+            Stats m_stats{};
+            async_context_t *m_ctx = nullptr;
+            async_at_time_worker_t m_worker{};
+            bool m_armed = false;
+    };
+
+} // namespace async_tcp
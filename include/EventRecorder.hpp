@@ -0,0 +1,118 @@
+/**
+ * @file EventRecorder.hpp
+ * @brief Compact recorder of the lwIP event sequence seen by the library.
+ *
+ * With ASYNC_TCP_EVENT_RECORDER defined, the lwIP entry points
+ * (lwip_receive_callback, lwip_sent_cb and the poll, error and connected
+ * callbacks of TcpClientContext) append one 12-byte EventRecord each while
+ * recording is active. Receive records carry the pbuf chain length and,
+ * optionally, an FNV-1a hash of the payload. A chain of more than one pbuf
+ * is followed by one Segment record per element with that pbuf's len, so
+ * the replay rebuilds the same segmentation; a chain is recorded whole or
+ * dropped whole.
+ *
+ * The trace is written with dump() and fed back into a TcpClientContext by
+ * EventReplayer, turning a production capture into a repeatable benchmark.
+ *
+ * Trace format (little-endian):
+ *  - header: "ATEV", version (u8), record size (u8), reserved (u16),
+ *    record count (u32), dropped records (u32)
+ *  - records: t_us (u32), hash (u32), len (u16), type (u8), client id (u8)
+ *
+ * For Error and Connected records, len holds the err_t value; Segment
+ * records have hash 0.
+ *
+ * Records are only written from the networking core (inside lwIP
+ * callbacks); start(), stop() and dump() belong on that core as well.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <cstddef>
+#include <cstdint>
+#include <lwip/pbuf.h>
+
+#ifndef ASYNC_TCP_EVENT_RECORDER_CAPACITY
+#define ASYNC_TCP_EVENT_RECORDER_CAPACITY 512 // records, 12 bytes each
+#endif
+
+namespace async_tcp {
+
+    enum class EventType : uint8_t {
+        Recv = 1,  ///< Data segment appended to IoRxBuffer
+        Fin,       ///< Remote FIN (lwip_receive_callback with p == nullptr)
+        Sent,      ///< Bytes ACKed by the peer (lwip_sent_cb)
+        Poll,      ///< tcp_poll tick
+        Error,     ///< tcp_err, PCB already freed by lwIP
+        Connected, ///< tcp_connect completion
+        Segment    ///< One pbuf of the preceding Recv chain
+    };
+
+    struct EventRecord {
+            uint32_t t_us;     ///< time_us_32() when lwIP invoked us
+            uint32_t hash;     ///< FNV-1a of the payload (Recv only, or 0)
+            uint16_t len;      ///< Byte count, or err_t for Error/Connected
+            EventType type;    ///< Event kind
+            uint8_t client_id; ///< TcpClientContext client id
+    };
+
+    static_assert(sizeof(EventRecord) == 12, "EventRecord must stay compact");
+
+    class EventRecorder {
+        public:
+            static constexpr uint8_t FORMAT_VERSION = 2;
+            static constexpr std::size_t HEADER_SIZE = 16;
+
+            /**
+             * @brief Clear the trace and start recording.
+             * @param hash_payloads Hash Recv payloads (costs one pass over
+             * each pbuf chain).
+             */
+            static void start(bool hash_payloads = true);
+
+            static void stop();
+
+            [[nodiscard]] static bool active();
+
+            static void record(EventType type, uint8_t client_id,
+                               uint16_t len, uint32_t hash = 0);
+
+            static void recordError(EventType type, uint8_t client_id,
+                                    err_t err);
+
+            static void recordRecv(uint8_t client_id, const pbuf *p);
+
+            [[nodiscard]] static std::size_t size();
+
+            [[nodiscard]] static uint32_t dropped();
+
+            [[nodiscard]] static const EventRecord *records();
+
+            /**
+             * @brief Write the trace in the format described above.
+             * @return Number of bytes written.
+             */
+            static std::size_t dump(Print &out);
+    };
+
+} // namespace async_tcp
+
+#ifdef ASYNC_TCP_EVENT_RECORDER
+#define ASYNC_TCP_RECORD(type, id, len)                                        \
+    ::async_tcp::EventRecorder::record(::async_tcp::EventType::type, id, len)
+#define ASYNC_TCP_RECORD_ERR(type, id, err)                                    \
+    ::async_tcp::EventRecorder::recordError(::async_tcp::EventType::type, id,  \
+                                            err)
+#define ASYNC_TCP_RECORD_RECV(id, p) ::async_tcp::EventRecorder::recordRecv(id, p)
+#else
+#define ASYNC_TCP_RECORD(type, id, len)                                        \
+    do {                                                                       \
+    } while (0)
+#define ASYNC_TCP_RECORD_ERR(type, id, err)                                    \
+    do {                                                                       \
+    } while (0)
+#define ASYNC_TCP_RECORD_RECV(id, p)                                           \
+    do {                                                                       \
+    } while (0)
+#endif
@@ -0,0 +1,86 @@
+/**
+ * @file EventReplayer.hpp
+ * @brief Feeds an EventRecorder trace back into a TcpClientContext.
+ *
+ * The replayer drives the same entry points lwIP would call
+ * (lwip_receive_callback, lwip_sent_cb, the poll/error/connected callbacks)
+ * in recorded order, so IoRxBuffer, TcpWriter and the client handlers see
+ * the production event sequence with the recorded pbuf sizes. Payload bytes
+ * are regenerated deterministically from the recorded hash; the hash itself
+ * is only meant for comparing traces.
+ *
+ * Replay runs wherever lwIP is linked. Call it from the networking core's
+ * async context (or the host's single lwIP thread), with a context whose
+ * PCB came from tcp_new().
+ */
+
+#pragma once
+
+#include "EventRecorder.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace async_tcp {
+
+    class TcpClientContext;
+
+    class EventReplayer {
+        public:
+            struct Stats {
+                    std::size_t events = 0;      ///< Records delivered
+                    std::size_t rx_bytes = 0;    ///< Bytes fed as Recv
+                    std::size_t acked_bytes = 0; ///< Bytes fed as Sent
+                    std::size_t skipped = 0;     ///< Filtered or pbuf_alloc failed
+                    uint32_t elapsed_us = 0;     ///< Wall time of replay()
+            };
+
+            /**
+             * @param ctx Context receiving the events.
+             * @param client_id Replay only records of this client id, or all
+             * records when negative.
+             */
+            explicit EventReplayer(TcpClientContext &ctx, int client_id = -1);
+
+            /**
+             * @brief Attach a trace produced by EventRecorder::dump().
+             *
+             * The buffer is not copied and must outlive the replayer.
+             * @return false on a malformed header or truncated trace.
+             */
+            bool load(const uint8_t *trace, std::size_t size);
+
+            /**
+             * @brief Deliver the next record.
+             * @return false when the trace is exhausted.
+             */
+            bool step();
+
+            /**
+             * @brief Deliver all remaining records.
+             * @param paced Reproduce recorded inter-event gaps instead of
+             * running back to back.
+             */
+            const Stats &replay(bool paced = false);
+
+            void rewind();
+
+            [[nodiscard]] const Stats &stats() const { return m_stats; }
+
+            [[nodiscard]] std::size_t size() const { return m_count; }
+
+        private:
+            [[nodiscard]] EventRecord decode(std::size_t index) const;
+            void deliver(const EventRecord &record);
+            void deliverRecv(const EventRecord &record);
+            [[nodiscard]] std::size_t segmentsAt(std::size_t index) const;
+
+            TcpClientContext &m_ctx;
+            int m_client_filter;
+            const uint8_t *m_records = nullptr;
+            std::size_t m_count = 0;
+            std::size_t m_next = 0;
+            Stats m_stats{};
+    };
+
+} // namespace async_tcp
@@ -0,0 +1,92 @@
+/**
+ * @file HandleTable.hpp
+ * @brief Generation-tagged 32-bit client handles.
+ *
+ * A ClientHandle packs a slot index (low 8 bits) and the slot's generation
+ * (high 24 bits). A TcpClient attached to a table gets a fresh generation
+ * on every connect and on every close, so a handle captured for one
+ * connection stops resolving as soon as that connection ends. Handlers,
+ * completion records and scheduler tasks can carry the handle instead of a
+ * raw TcpClient pointer and drop stale events with a single compare.
+ *
+ * attach(), renew() and release() have a single writer (the networking
+ * core). isCurrent() and resolve() are lock-free and may run on any core.
+ * A resolved pointer stays valid as long as the TcpClient object does;
+ * release() its slot before destroying it.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#ifndef ASYNC_TCP_HANDLE_SLOTS
+#define ASYNC_TCP_HANDLE_SLOTS 32
+#endif
+
+namespace async_tcp {
+
+    class TcpClient;
+
+    using ClientHandle = uint32_t; ///< 0 is never a valid handle
+
+    class HandleTable {
+        public:
+            static constexpr ClientHandle INVALID = 0;
+            static constexpr uint8_t INDEX_BITS = 8;
+            static_assert(ASYNC_TCP_HANDLE_SLOTS <= (1u << INDEX_BITS),
+                          "ASYNC_TCP_HANDLE_SLOTS must fit the index bits");
+
+            static constexpr uint8_t indexOf(const ClientHandle handle) {
+                return static_cast<uint8_t>(handle);
+            }
+
+            static constexpr uint32_t generationOf(const ClientHandle handle) {
+                return handle >> INDEX_BITS;
+            }
+
+            /**
+             * @brief Take a free slot for @p client.
+             * @return The first handle, INVALID if the table is full.
+             */
+            ClientHandle attach(TcpClient &client);
+
+            /**
+             * @brief Invalidate @p handle and issue the slot's next one.
+             * @return INVALID if @p handle is already stale.
+             */
+            ClientHandle renew(ClientHandle handle);
+
+            /**
+             * @brief Invalidate @p handle and free its slot.
+             */
+            void release(ClientHandle handle);
+
+            [[nodiscard]] bool isCurrent(const ClientHandle handle) const {
+                const uint8_t index = indexOf(handle);
+                return handle != INVALID && index < ASYNC_TCP_HANDLE_SLOTS &&
+                       m_slots[index].handle.load(std::memory_order_acquire) ==
+                           handle;
+            }
+
+            /**
+             * @brief The client of @p handle, nullptr if it is stale.
+             */
+            [[nodiscard]] TcpClient *resolve(const ClientHandle handle) const {
+                return isCurrent(handle) ? m_slots[indexOf(handle)].client
+                                         : nullptr;
+            }
+
+        private:
+            struct Slot {
+                    std::atomic<ClientHandle> handle{INVALID};
+                    TcpClient *client = nullptr;
+                    uint32_t generation = 0; ///< Last issued, kept across reuse
+            };
+
+            ClientHandle next(uint8_t index);
+
+            Slot m_slots[ASYNC_TCP_HANDLE_SLOTS]{};
+    };
+
+} // namespace async_tcp
@@ -6,9 +6,12 @@
 
 namespace async_tcp {
 
+    class StageTimings;
+
     using receive_cb = tcp_recv_fn;
     using fin_callback_t = std::function<void()>;
     using received_callback_t = std::function<void()>;
+    using drained_callback_t = std::function<void()>;
 
     extern "C" {
     /**
@@ -52,7 +55,10 @@ namespace async_tcp {
             pbuf *_head{};           ///< Head of the pbuf chain or nullptr
             std::size_t _offset{};   ///< Byte offset into current head payload
             received_callback_t _receivedCb{};
+            drained_callback_t _drainedCb{};
             fin_callback_t _finCb = nullptr;
+            StageTimings *_timings = nullptr; ///< RX stage timing, null = off
+            uint64_t _received_total{}; ///< Bytes appended by lwIP, ever
 
             void _onReceivedCallback() const;
             void _onFinCallback() const;
@@ -131,6 +137,24 @@ namespace async_tcp {
              * @param cb Functor invoked when new data is appended by lwIP.
              */
             void setOnReceivedCallback(const received_callback_t &cb);
+
+            /**
+             * @brief Register a callback for peekConsume() emptying the chain.
+             */
+            void setOnDrainedCallback(const drained_callback_t &cb);
+
+            /**
+             * @brief Attach (or detach with nullptr) RX stage timing. The
+             * first peek after new data arrives marks the handler start.
+             */
+            void setStageTimings(StageTimings *timings) { _timings = timings; }
+
+            /**
+             * @brief Bytes lwIP delivered to this buffer since construction.
+             */
+            [[nodiscard]] uint64_t receivedTotal() const {
+                return _received_total;
+            }
     };
 
 } // namespace async_tcp
@@ -0,0 +1,133 @@
+/**
+ * @file LatencyHistogram.hpp
+ * @brief Fixed-size log-linear latency histogram with seqlock snapshots.
+ *
+ * Values (microseconds) below 4 get a bucket each; above that every power
+ * of two is split into 4 linear sub-buckets, so a bucket's width is at most
+ * 25% of its lower bound (HDR-style, 2 significant bits). Values from
+ * 2^27 us (~134 s) on share the last bucket; the exact maximum is kept
+ * separately. The whole histogram is about 440 bytes and never allocates.
+ *
+ * Concurrency: record(), merge() and reset() belong to a single writer
+ * (typically the networking core) and are wait-free. snapshot() may run
+ * on any core and retries until it copies a state no write overlapped,
+ * using a sequence counter (seqlock).
+ *
+ * Serialization is a compact varint encoding of the non-empty buckets,
+ * see Snapshot::serialize().
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace async_tcp {
+
+    class LatencyHistogram {
+        public:
+            static constexpr uint8_t SUB_BITS = 2;
+            static constexpr uint32_t SUB_COUNT = 1U << SUB_BITS;
+            static constexpr uint8_t MAX_EXPONENT = 26; ///< Last full octave
+            static constexpr std::size_t BUCKETS =
+                SUB_COUNT + (MAX_EXPONENT - SUB_BITS + 1) * SUB_COUNT;
+
+            static constexpr uint8_t FORMAT_VERSION = 1;
+            /// Upper bound of Snapshot::serialize() output.
+            static constexpr std::size_t MAX_SERIALIZED_SIZE =
+                1 + 5 + 5 + 10 + BUCKETS * (1 + 5);
+
+            struct Snapshot {
+                    uint64_t sum_us = 0;
+                    uint32_t count = 0;
+                    uint32_t max_us = 0;
+                    uint32_t buckets[BUCKETS]{};
+
+                    /**
+                     * @brief Value at percentile @p pct (0..100): the upper
+                     * bound of the bucket reaching that rank, capped at the
+                     * recorded maximum.
+                     */
+                    [[nodiscard]] uint32_t percentile(float pct) const;
+
+                    [[nodiscard]] uint32_t mean() const {
+                        return count ? static_cast<uint32_t>(sum_us / count)
+                                     : 0;
+                    }
+
+                    void merge(const Snapshot &other);
+
+                    /**
+                     * @brief Encode as: version (u8), varint non-empty bucket
+                     * count, varint max, varint sum, then per non-empty bucket
+                     * varint index gap and varint count.
+                     * @return Bytes written, or 0 if @p cap is too small.
+                     */
+                    std::size_t serialize(uint8_t *out, std::size_t cap) const;
+
+                    /**
+                     * @brief Decode serialize() output, replacing this
+                     * snapshot.
+                     * @return false on a malformed or truncated input.
+                     */
+                    bool deserialize(const uint8_t *in, std::size_t len);
+            };
+
+            LatencyHistogram() = default;
+
+            LatencyHistogram(const LatencyHistogram &) = delete;
+            LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+
+            /**
+             * @brief Record one value (single writer).
+             */
+            void record(const uint32_t us) {
+                begin();
+                ++m_data.buckets[bucketOf(us)];
+                ++m_data.count;
+                m_data.sum_us += us;
+                if (us > m_data.max_us) {
+                    m_data.max_us = us;
+                }
+                end();
+            }
+
+            /**
+             * @brief Add another histogram's counts (single writer).
+             */
+            void merge(const Snapshot &other);
+
+            /**
+             * @brief Clear all counts (single writer).
+             */
+            void reset();
+
+            /**
+             * @brief Consistent copy, callable from any core.
+             */
+            [[nodiscard]] Snapshot snapshot() const;
+
+            [[nodiscard]] static std::size_t bucketOf(uint32_t us);
+
+            [[nodiscard]] static uint32_t lowerBound(std::size_t bucket);
+
+            [[nodiscard]] static uint32_t upperBound(std::size_t bucket);
+
+        private:
+            void begin() {
+                m_seq.store(m_seq.load(std::memory_order_relaxed) + 1,
+                            std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+            }
+
+            void end() {
+                m_seq.store(m_seq.load(std::memory_order_relaxed) + 1,
+                            std::memory_order_release);
+            }
+
+            std::atomic<uint32_t> m_seq{0}; ///< Odd while a write is running
+            Snapshot m_data{};
+    };
+
+} // namespace async_tcp
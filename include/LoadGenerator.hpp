@@ -0,0 +1,137 @@
+/**
+ * @file LoadGenerator.hpp
+ * @brief Configurable TCP load generator over the library data path.
+ *
+ * LoadGenerator grew out of the QOTD/echo mirror stress example. It opens
+ * a configurable number of connections through TcpClientContext and moves
+ * data with TcpWriter and IoRxBuffer, against LoadServers on the same
+ * device, a host build, or any external QOTD/echo/discard/chargen server:
+ *
+ *  - Echo: request/response; latency is write start to full echo.
+ *  - Qotd: one quote per connection; latency is connect start to FIN.
+ *  - Discard: TX throughput; a message every think time.
+ *  - Chargen: RX throughput.
+ *
+ * The report gives connections/s, MB/s and request latency percentiles.
+ *
+ * start(), poll() and stop() must run with the lwIP lock held (on the
+ * networking core's async context, or between ethernet_arch_lwip_begin()
+ * and ethernet_arch_lwip_end()). lwIP callbacks only update counters;
+ * connections are opened and torn down in poll().
+ */
+
+#pragma once
+
+#include "LatencyHistogram.hpp"
+
+#include <Arduino.h>
+#include <IPAddress.h>
+#include <cstddef>
+#include <cstdint>
+
+#ifndef ASYNC_TCP_LOAD_MAX_CONNS
+#define ASYNC_TCP_LOAD_MAX_CONNS 32
+#endif
+
+namespace async_tcp {
+
+    class TcpClientContext;
+
+    class LoadGenerator {
+        public:
+            enum class Mode : uint8_t { Echo, Qotd, Discard, Chargen };
+
+            struct Config {
+                    IPAddress server{};
+                    uint16_t port = 7;
+                    Mode mode = Mode::Echo;
+                    uint16_t connections = 4;   ///< <= ASYNC_TCP_LOAD_MAX_CONNS
+                    uint32_t message_size = 256; ///< Bytes per request/message
+                    uint32_t think_time_ms = 0;  ///< Pause between requests
+                    uint32_t duration_ms = 10000;
+                    uint32_t requests_per_connection = 0; ///< 0 = keep open
+            };
+
+            struct Report {
+                    uint32_t elapsed_ms = 0;
+                    uint32_t connections = 0; ///< Successfully opened
+                    uint32_t connect_failures = 0;
+                    uint32_t errors = 0; ///< tcp_err on an open connection
+                    uint32_t requests = 0;
+                    uint64_t bytes_tx = 0;
+                    uint64_t bytes_rx = 0;
+                    float connections_per_s = 0;
+                    float mb_per_s = 0; ///< (tx + rx) / elapsed, 10^6 bytes
+                    uint32_t latency_p50_us = 0;
+                    uint32_t latency_p90_us = 0;
+                    uint32_t latency_p99_us = 0;
+                    uint32_t latency_max_us = 0;
+            };
+
+            explicit LoadGenerator(const Config &config);
+            ~LoadGenerator();
+
+            LoadGenerator(const LoadGenerator &) = delete;
+            LoadGenerator &operator=(const LoadGenerator &) = delete;
+
+            void start();
+
+            /**
+             * @brief Advance every connection's state machine.
+             * @return false once the configured duration has elapsed and all
+             * connections are closed.
+             */
+            bool poll();
+
+            /**
+             * @brief Close all connections now.
+             */
+            void stop();
+
+            [[nodiscard]] Report report() const;
+
+            /**
+             * @brief Full latency distribution of the run, e.g. to merge
+             * several generators or serialize it.
+             */
+            [[nodiscard]] LatencyHistogram::Snapshot latency() const {
+                return m_latency.snapshot();
+            }
+
+            static void print(const Report &report, Print &out);
+
+        private:
+            enum class State : uint8_t { Idle, Connecting, Active };
+
+            struct Conn {
+                    LoadGenerator *owner = nullptr;
+                    TcpClientContext *ctx = nullptr;
+                    uint8_t id = 0;
+                    State state = State::Idle;
+                    uint64_t t_start_us = 0;  ///< connect or request start
+                    uint64_t next_us = 0;     ///< next action due
+                    std::size_t to_send = 0;
+                    volatile std::size_t received = 0;
+                    uint32_t requests = 0;
+                    volatile bool connected = false;
+                    volatile bool fin = false;
+                    volatile bool failed = false;
+            };
+
+            void open(Conn &c, uint64_t now);
+            void close(Conn &c, uint64_t now);
+            void pump(Conn &c, uint64_t now);
+            void send(Conn &c);
+            void onReceive(Conn &c);
+            void sample(uint64_t latency_us);
+
+            Config m_config;
+            Conn m_conns[ASYNC_TCP_LOAD_MAX_CONNS]{};
+            uint64_t m_started_us = 0;
+            uint64_t m_ended_us = 0;
+            bool m_running = false;
+            Report m_counters{};
+            LatencyHistogram m_latency;
+    };
+
+} // namespace async_tcp
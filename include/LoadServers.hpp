@@ -0,0 +1,113 @@
+/**
+ * @file LoadServers.hpp
+ * @brief Local QOTD, echo, discard and chargen stand-in servers.
+ *
+ * Minimal lwIP raw-API implementations of the classic test services
+ * (RFC 865, 862, 863, 864), so load and stress runs need no external
+ * servers. Each service listens on its own port; accepted connections use
+ * a fixed pool of ASYNC_TCP_LOAD_SERVER_CONNS slots and never allocate.
+ *
+ * The echo server applies backpressure: received data is acknowledged to
+ * the peer (tcp_recved) only once it has been queued back, so a slow
+ * reader throttles the writer exactly as a real echo server would.
+ *
+ * begin()/end() must run with the lwIP lock held, like LoadGenerator.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <lwip/tcp.h>
+
+#ifndef ASYNC_TCP_LOAD_SERVER_CONNS
+#define ASYNC_TCP_LOAD_SERVER_CONNS 16
+#endif
+
+namespace async_tcp {
+
+    class LoadServers {
+        public:
+            enum class Service : uint8_t { Qotd = 0, Echo, Discard, Chargen };
+
+            static constexpr uint16_t QOTD_PORT = 17;
+            static constexpr uint16_t ECHO_PORT = 7;
+            static constexpr uint16_t DISCARD_PORT = 9;
+            static constexpr uint16_t CHARGEN_PORT = 19;
+
+            struct Stats {
+                    uint32_t accepted = 0;
+                    uint32_t rejected = 0; ///< No free connection slot
+                    uint64_t bytes_in = 0;
+                    uint64_t bytes_out = 0;
+            };
+
+            LoadServers() = default;
+            ~LoadServers() { end(); }
+
+            LoadServers(const LoadServers &) = delete;
+            LoadServers &operator=(const LoadServers &) = delete;
+
+            /**
+             * @brief Start listening for @p service on @p port.
+             * @return false if the port cannot be bound or the service is
+             * already running.
+             */
+            bool begin(Service service, uint16_t port);
+
+            /**
+             * @brief Start all four services on their standard ports plus
+             * @p port_offset (non-root friendly on a host build).
+             */
+            bool beginAll(uint16_t port_offset = 0);
+
+            /**
+             * @brief Abort every connection and close every listener.
+             */
+            void end();
+
+            /**
+             * @brief Quote served by QOTD; the pointer must stay valid.
+             */
+            void setQuote(const char *quote) { m_quote = quote; }
+
+            [[nodiscard]] const Stats &stats(Service service) const {
+                return m_stats[static_cast<uint8_t>(service)];
+            }
+
+        private:
+            struct Conn {
+                    LoadServers *owner = nullptr;
+                    tcp_pcb *pcb = nullptr;
+                    pbuf *pending = nullptr; ///< Echo data not yet queued
+                    uint16_t pending_offset = 0;
+                    uint32_t chargen_pos = 0;
+                    Service service = Service::Echo;
+            };
+
+            static err_t s_accept(void *arg, tcp_pcb *pcb, err_t err);
+            static err_t s_recv(void *arg, tcp_pcb *pcb, pbuf *p, err_t err);
+            static err_t s_sent(void *arg, tcp_pcb *pcb, u16_t len);
+            static void s_error(void *arg, err_t err);
+
+            err_t accept(Service service, tcp_pcb *pcb);
+            void echoFlush(Conn &c);
+            void chargenFill(Conn &c);
+            err_t release(Conn &c, bool abort);
+            Conn *slot();
+
+            struct Listener {
+                    LoadServers *owner = nullptr;
+                    tcp_pcb *pcb = nullptr;
+                    Service service = Service::Echo;
+            };
+
+            Listener m_listeners[4]{};
+            Conn m_conns[ASYNC_TCP_LOAD_SERVER_CONNS]{};
+            Stats m_stats[4]{};
+            const char *m_quote =
+                "\"Premature optimization is the root of all evil.\" "
+                "- Donald Knuth\r\n";
+    };
+
+} // namespace async_tcp
@@ -0,0 +1,98 @@
+/**
+ * @file MagazineAllocator.hpp
+ * @brief Size-class allocator with per-core magazines for small messages.
+ *
+ * Library payloads such as the TcpClientSyncAccessor's AccessorPayload are
+ * allocated on one core and freed on the other. Through malloc both sides
+ * serialize on the global heap lock, and the short-lived blocks scatter
+ * holes between long-lived ones.
+ *
+ * MagazineAllocator serves requests of up to MAX_SIZE bytes from static
+ * arenas, one per size class (16, 32, 64 and 128 bytes, each with
+ * ASYNC_TCP_MAG_BLOCKS blocks):
+ *
+ *  - Each core keeps a magazine of up to ASYNC_TCP_MAG_ROUNDS free blocks
+ *    per class. Allocation pops from, and freeing pushes to, the calling
+ *    core's magazine with interrupts briefly masked; no lock is taken.
+ *  - A block freed on the other core simply lands in that core's
+ *    magazine. Magazines that run empty or full exchange half a magazine
+ *    with the shared depot in one batch, under a hardware spin lock held
+ *    for a handful of pointer moves (the Cortex-M0+ has no
+ *    compare-and-swap, so this is the cheapest cross-core exchange).
+ *  - The depot hands out never-used arena blocks on demand, so the
+ *    arenas need no initialisation and work before static constructors.
+ *
+ * Larger requests and exhausted classes fall back to the heap and are
+ * counted as overflows. Derive a class from MagazineAllocated to route
+ * its new/delete here; unique_ptr and make_unique keep working. This
+ * covers one-shot EphemeralBridge subclasses as well: deleting through
+ * the bridge base still lands in the matching class. Size
+ * ASYNC_TCP_MAG_BLOCKS from the high-water marks print() reports.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <cstddef>
+#include <cstdint>
+
+#ifndef ASYNC_TCP_MAG_BLOCKS
+#define ASYNC_TCP_MAG_BLOCKS 16 // blocks per size class
+#endif
+#ifndef ASYNC_TCP_MAG_ROUNDS
+#define ASYNC_TCP_MAG_ROUNDS 8 // free blocks cached per core and class
+#endif
+
+namespace async_tcp {
+
+    class MagazineAllocator {
+        public:
+            static constexpr std::size_t CLASSES = 4;
+            static constexpr std::size_t MAX_SIZE = 128;
+
+            struct Stats {
+                    uint32_t block_size = 0;
+                    uint32_t capacity = 0;
+                    uint32_t in_use = 0;     ///< Allocations not yet freed
+                    uint32_t high_water = 0; ///< Arena blocks ever handed out
+                    uint32_t allocations = 0;
+                    uint32_t frees = 0;
+                    uint32_t depot_refills = 0; ///< Batches taken from the depot
+                    uint32_t depot_returns = 0; ///< Batches given back
+                    uint32_t overflows = 0;     ///< Served from the heap
+            };
+
+            /**
+             * @brief A block of at least @p size bytes, 8-byte aligned.
+             */
+            static void *allocate(std::size_t size);
+
+            /**
+             * @brief Free @p p from allocate(), on either core.
+             */
+            static void deallocate(void *p);
+
+            /**
+             * @brief Counters of size class @p cls (< CLASSES), summed over
+             * both cores.
+             */
+            [[nodiscard]] static Stats stats(std::size_t cls);
+
+            static void print(Print &out);
+    };
+
+    /**
+     * @brief Mixin giving a class MagazineAllocator-backed new/delete.
+     */
+    class MagazineAllocated {
+        public:
+            static void *operator new(const std::size_t size) {
+                return MagazineAllocator::allocate(size);
+            }
+
+            static void operator delete(void *p) {
+                MagazineAllocator::deallocate(p);
+            }
+    };
+
+} // namespace async_tcp
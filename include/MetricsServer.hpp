@@ -0,0 +1,129 @@
+/**
+ * @file MetricsServer.hpp
+ * @brief Optional Prometheus text-format endpoint for library counters.
+ *
+ * MetricsServer is a small lwIP raw-API HTTP/1.0 listener. Any request on
+ * its port is answered with the library's metrics in Prometheus text
+ * format (version 0.0.4):
+ *
+ *  - global: heap in use, lwIP TCP segment counters, TokenLog and
+ *    EventRecorder drops, scrapes served;
+ *  - per registered TcpClient: connects, FINs, errors, polls, stalls,
+ *    RX/TX/ACKed bytes and whether it is connected (polls and stalls only
+ *    count while tcp_poll runs: with a poll consumer, or build with
+ *    ASYNC_TCP_STALL_POLL set);
+ *  - lwIP memp pool usage (with LWIP_STATS and MEMP_STATS);
+ *  - per client StageTimings histograms as summaries (when enabled).
+ *
+ * The body is produced one line at a time into a fixed line buffer and
+ * copied into the TCP send buffer as room allows; rendering resumes from
+ * the sent callback. A scrape therefore never allocates and never needs
+ * more than one line of extra RAM per scrape connection.
+ *
+ * All methods must run with the lwIP lock held (networking core), and
+ * registered clients must outlive their registration.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <lwip/tcp.h>
+
+#ifndef ASYNC_TCP_METRICS_MAX_CLIENTS
+#define ASYNC_TCP_METRICS_MAX_CLIENTS 8
+#endif
+
+#ifndef ASYNC_TCP_METRICS_CONNS
+#define ASYNC_TCP_METRICS_CONNS 2 // concurrent scrapes
+#endif
+
+namespace async_tcp {
+
+    class TcpClient;
+
+    class MetricsServer {
+        public:
+            static constexpr uint16_t DEFAULT_PORT = 9100;
+            static constexpr std::size_t LINE_SIZE = 192;
+
+            MetricsServer() = default;
+            ~MetricsServer() { end(); }
+
+            MetricsServer(const MetricsServer &) = delete;
+            MetricsServer &operator=(const MetricsServer &) = delete;
+
+            bool begin(uint16_t port = DEFAULT_PORT);
+
+            /**
+             * @brief Abort running scrapes and stop listening.
+             */
+            void end();
+
+            /**
+             * @brief Export @p client's counters, labelled with its client id.
+             * @return false when all ASYNC_TCP_METRICS_MAX_CLIENTS slots are
+             * taken.
+             */
+            bool addClient(const TcpClient *client);
+
+            void removeClient(const TcpClient *client);
+
+            [[nodiscard]] uint32_t scrapes() const { return m_scrapes; }
+
+        private:
+            enum class Section : uint8_t {
+                Headers,
+                Global,
+                Client,
+                Memp,
+                Stages,
+                Done
+            };
+
+            struct Cursor {
+                    Section section = Section::Headers;
+                    uint8_t family = 0; ///< Metric family within the section
+                    uint16_t item = 0;  ///< 0 = HELP, 1 = TYPE, then samples
+            };
+
+            struct Conn {
+                    MetricsServer *owner = nullptr;
+                    tcp_pcb *pcb = nullptr;
+                    bool requested = false;
+                    uint8_t idle_polls = 0; ///< Polls without progress
+                    Cursor cursor{};
+                    uint8_t line_len = 0; ///< Pending line not yet queued
+                    char line[LINE_SIZE]{};
+            };
+
+            static err_t s_accept(void *arg, tcp_pcb *pcb, err_t err);
+            static err_t s_recv(void *arg, tcp_pcb *pcb, pbuf *p, err_t err);
+            static err_t s_sent(void *arg, tcp_pcb *pcb, u16_t len);
+            static void s_error(void *arg, err_t err);
+            static err_t s_poll(void *arg, tcp_pcb *pcb);
+
+            err_t pump(Conn &c);
+            err_t release(Conn &c, bool abort);
+
+            /**
+             * @brief Render the next line at the cursor into c.line.
+             * @return false once the body is complete.
+             */
+            bool nextLine(Conn &c);
+            bool globalLine(Conn &c);
+            bool clientLine(Conn &c);
+            bool mempLine(Conn &c);
+            bool stageLine(Conn &c);
+
+            int header(Conn &c, const char *name, const char *help,
+                       const char *type);
+            const TcpClient *clientAt(uint16_t n) const;
+
+            tcp_pcb *m_listen = nullptr;
+            Conn m_conns[ASYNC_TCP_METRICS_CONNS]{};
+            const TcpClient *m_clients[ASYNC_TCP_METRICS_MAX_CLIENTS]{};
+            uint32_t m_scrapes = 0;
+    };
+
+} // namespace async_tcp
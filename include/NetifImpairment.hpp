@@ -0,0 +1,143 @@
+/**
+ * @file NetifImpairment.hpp
+ * @brief Deterministic network impairment stage for an lwIP netif.
+ *
+ * NetifImpairment interposes on a netif's input and linkoutput functions and
+ * applies, per direction, latency, jitter, loss, reordering, a bandwidth
+ * limit and an optional zero-window rewrite of inbound TCP segments. All
+ * random decisions come from a seeded xorshift32 generator, so a given seed
+ * and traffic pattern reproduces the same impairment run after run.
+ *
+ * Delayed frames wait in a fixed-size queue and are released by poll(),
+ * which must run on the networking core (the same context lwIP runs in)
+ * at least as often as the desired latency resolution. Frames are also
+ * released opportunistically whenever traffic passes through the stage.
+ *
+ * Works with any netif: on target it can impair the real Wi-Fi interface,
+ * in a host lwIP build the loopback or an in-memory netif. Only one netif
+ * can be impaired at a time.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <lwip/netif.h>
+#include <lwip/pbuf.h>
+
+#ifndef ASYNC_TCP_IMPAIR_QUEUE_LEN
+#define ASYNC_TCP_IMPAIR_QUEUE_LEN 32 // delayed frames, both directions
+#endif
+
+namespace async_tcp {
+
+    struct ImpairmentProfile {
+            uint32_t latency_us = 0;  ///< Fixed one-way delay
+            uint32_t jitter_us = 0;   ///< Uniform extra delay in [0, jitter]
+            uint32_t loss_ppm = 0;    ///< Drop probability, parts per million
+            uint32_t reorder_ppm = 0; ///< Probability a frame is held back
+            uint32_t reorder_us = 0;  ///< Extra delay of a held back frame
+            uint32_t rate_bps = 0;    ///< Link rate, 0 = unlimited
+            bool zero_window = false; ///< Ingress only: advertise wnd = 0
+
+            /** @brief Clean 802.11n link, short range. */
+            static ImpairmentProfile wifiGood() {
+                return {2000, 1000, 100, 0, 0, 20000000, false};
+            }
+
+            /** @brief Congested 2.4 GHz channel with retries and loss. */
+            static ImpairmentProfile wifiLossy() {
+                return {8000, 12000, 20000, 5000, 6000, 4000000, false};
+            }
+
+            /** @brief Marginal signal: heavy loss, long tails, low rate. */
+            static ImpairmentProfile wifiMarginal() {
+                return {20000, 60000, 60000, 20000, 30000, 1000000, false};
+            }
+    };
+
+    class NetifImpairment {
+        public:
+            enum class Direction : uint8_t { Ingress = 0, Egress = 1 };
+
+            struct Stats {
+                    uint32_t passed = 0;     ///< Frames delivered
+                    uint32_t dropped = 0;    ///< Frames lost on purpose
+                    uint32_t reordered = 0;  ///< Frames held back
+                    uint32_t queue_full = 0; ///< Frames tail-dropped
+                    uint32_t window_rewrites = 0;
+            };
+
+            explicit NetifImpairment(uint32_t seed = 1);
+
+            ~NetifImpairment() { detach(); }
+
+            NetifImpairment(const NetifImpairment &) = delete;
+            NetifImpairment &operator=(const NetifImpairment &) = delete;
+
+            /**
+             * @brief Start impairing @p nif. Fails if another instance is
+             * attached.
+             */
+            bool attach(netif *nif);
+
+            /**
+             * @brief Flush queued frames and restore the netif functions.
+             */
+            void detach();
+
+            void setProfile(Direction dir, const ImpairmentProfile &profile);
+
+            [[nodiscard]] const ImpairmentProfile &
+            profile(Direction dir) const {
+                return m_profile[static_cast<uint8_t>(dir)];
+            }
+
+            /**
+             * @brief Reseed the generator; resets statistics.
+             */
+            void reseed(uint32_t seed);
+
+            /**
+             * @brief Release every queued frame whose due time has passed.
+             */
+            void poll();
+
+            [[nodiscard]] const Stats &stats(Direction dir) const {
+                return m_stats[static_cast<uint8_t>(dir)];
+            }
+
+            [[nodiscard]] std::size_t queued() const { return m_used; }
+
+        private:
+            struct Slot {
+                    pbuf *p;
+                    uint32_t due_us;
+                    Direction dir;
+            };
+
+            static err_t s_input(pbuf *p, netif *nif);
+            static err_t s_linkoutput(netif *nif, pbuf *p);
+
+            err_t impair(Direction dir, pbuf *p);
+            void deliver(Direction dir, pbuf *p);
+            void rewriteWindow(pbuf *p);
+            uint32_t next();
+            bool chance(uint32_t ppm);
+
+            netif *m_netif = nullptr;
+            netif_input_fn m_input = nullptr;
+            netif_linkoutput_fn m_linkoutput = nullptr;
+
+            ImpairmentProfile m_profile[2]{};
+            Stats m_stats[2]{};
+            uint32_t m_link_free_us[2]{};
+            uint32_t m_rng;
+
+            Slot m_queue[ASYNC_TCP_IMPAIR_QUEUE_LEN]{};
+            std::size_t m_used = 0;
+
+            static NetifImpairment *s_instance;
+    };
+
+} // namespace async_tcp
@@ -0,0 +1,158 @@
+/**
+ * @file PointerMap.hpp
+ * @brief Fixed-capacity open-addressing map keyed by pointer address.
+ *
+ * Drop-in replacement for the TaskRegistry pattern (a fixed-size singly
+ * linked list keyed by handler address, see examples/README.md), whose
+ * lookup and removal are O(n) on every message. PointerMap keeps the same
+ * guarantees: all storage is a member array, nothing is allocated after
+ * construction and the worst case is bounded by CAPACITY probes.
+ *
+ * Keys are hashed with Fibonacci hashing of the address (low alignment
+ * bits dropped) and collisions resolved by linear probing. erase() uses
+ * backward-shift deletion instead of tombstones, so probe sequences never
+ * grow with churn and a long-running add/remove cycle stays O(1) on
+ * average. Keep the load below about 3/4 of CAPACITY for short probes.
+ *
+ * Not synchronised: like TaskRegistry, mutate it on one core (e.g. from
+ * a SyncBridge onExecute()).
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace async_tcp {
+
+    template <typename V, std::size_t CAPACITY> class PointerMap {
+        public:
+            static_assert(CAPACITY >= 2 && (CAPACITY & (CAPACITY - 1)) == 0,
+                          "PointerMap capacity must be a power of two");
+
+            /**
+             * @brief Insert or replace the value of @p key.
+             * @return false if @p key is null or the map is full.
+             */
+            bool insert(const void *key, V value) {
+                if (!key) {
+                    return false;
+                }
+                std::size_t i = home(key);
+                for (std::size_t n = 0; n < CAPACITY; ++n) {
+                    Slot &s = m_slots[i];
+                    if (!s.key || s.key == key) {
+                        if (!s.key) {
+                            s.key = key;
+                            ++m_size;
+                        }
+                        s.value = std::move(value);
+                        return true;
+                    }
+                    i = (i + 1) & MASK;
+                }
+                return false;
+            }
+
+            /**
+             * @brief The value of @p key, or nullptr.
+             */
+            [[nodiscard]] V *find(const void *key) {
+                const std::size_t i = locate(key);
+                return i == NONE ? nullptr : &m_slots[i].value;
+            }
+
+            [[nodiscard]] bool contains(const void *key) const {
+                return locate(key) != NONE;
+            }
+
+            /**
+             * @brief Remove @p key, moving its value into @p out if given.
+             * @return false if @p key was not present.
+             */
+            bool erase(const void *key, V *out = nullptr) {
+                std::size_t hole = locate(key);
+                if (hole == NONE) {
+                    return false;
+                }
+                if (out) {
+                    *out = std::move(m_slots[hole].value);
+                }
+                // Backward shift: pull later entries of the cluster into the
+                // hole unless that would move them before their home slot.
+                // In a full map the cluster wraps around to the hole itself.
+                for (std::size_t j = (hole + 1) & MASK;
+                     j != hole && m_slots[j].key; j = (j + 1) & MASK) {
+                    const std::size_t h = home(m_slots[j].key);
+                    if (((j - h) & MASK) >= ((j - hole) & MASK)) {
+                        m_slots[hole] = std::move(m_slots[j]);
+                        hole = j;
+                    }
+                }
+                m_slots[hole].key = nullptr;
+                m_slots[hole].value = V{};
+                --m_size;
+                return true;
+            }
+
+            /**
+             * @brief Call @p fn(key, value) for every entry.
+             */
+            template <typename F> void forEach(F &&fn) {
+                for (auto &s : m_slots) {
+                    if (s.key) {
+                        fn(s.key, s.value);
+                    }
+                }
+            }
+
+            void clear() {
+                for (auto &s : m_slots) {
+                    s = Slot{};
+                }
+                m_size = 0;
+            }
+
+            [[nodiscard]] std::size_t size() const { return m_size; }
+            [[nodiscard]] bool empty() const { return m_size == 0; }
+            static constexpr std::size_t capacity() { return CAPACITY; }
+
+        private:
+            static constexpr std::size_t MASK = CAPACITY - 1;
+            static constexpr std::size_t NONE = CAPACITY;
+
+            struct Slot {
+                    const void *key = nullptr;
+                    V value{};
+            };
+
+            static std::size_t home(const void *key) {
+                // Handlers are at least word aligned; Fibonacci hashing
+                // mixes the remaining bits into the upper half of the word.
+                const auto a = static_cast<uint32_t>(
+                    reinterpret_cast<uintptr_t>(key) >> 2);
+                return static_cast<std::size_t>((a * 2654435769u) >> 16) &
+                       MASK;
+            }
+
+            [[nodiscard]] std::size_t locate(const void *key) const {
+                if (!key) {
+                    return NONE;
+                }
+                std::size_t i = home(key);
+                for (std::size_t n = 0; n < CAPACITY && m_slots[i].key;
+                     ++n) {
+                    if (m_slots[i].key == key) {
+                        return i;
+                    }
+                    i = (i + 1) & MASK;
+                }
+                return NONE;
+            }
+
+            Slot m_slots[CAPACITY]{};
+            std::size_t m_size = 0;
+    };
+
+} // namespace async_tcp
@@ -0,0 +1,170 @@
+/**
+ * @file PriorityScheduler.hpp
+ * @brief Priority classes for client event handlers on an async context.
+ *
+ * The Pico async_context runs pending workers in list order, so with many
+ * clients a burst of receive handlers can run ahead of a FIN or an error.
+ * PriorityScheduler owns a single when-pending worker on the networking
+ * context and three FIFO queues: Critical, Interactive and Bulk. Each time
+ * the worker runs it drains Critical, then Interactive, then at most
+ * bulkBatch() Bulk tasks before yielding, so lwIP can deliver new events
+ * and a newly queued critical event never waits behind a bulk backlog.
+ *
+ * A TcpClient with a scheduler attached (TcpClient::setScheduler) queues
+ * its connect, FIN and error events as Critical and its receive, ACK and
+ * poll events at the client's data priority, and dispatches them to
+ * ScheduledHandler objects. Before a FIN or error is queued, the client's
+ * pending data tasks are promoted to Critical, so per-connection order
+ * holds: data that arrived before the FIN is handled before it. Bridges keep working for events without a
+ * scheduled handler; their order is still up to the async context.
+ *
+ * Everything runs on the networking core under the context lock, so the
+ * queues need no further synchronisation. Repeated receive, poll and ACK
+ * events of one handler coalesce while queued (the data is in the RX
+ * buffer anyway; ACK byte counts add up).
+ *
+ * With a HandleTable set, tasks posted with a client handle are dropped
+ * at dispatch if that connection has since closed or reconnected.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <pico/async_context.h>
+
+#include "HandleTable.hpp"
+
+#ifndef ASYNC_TCP_SCHED_QUEUE
+#define ASYNC_TCP_SCHED_QUEUE 32 // tasks per priority class
+#endif
+
+namespace async_tcp {
+
+    class TcpClient;
+
+    /**
+     * @brief Receiver of scheduled client events.
+     *
+     * Events run some time after lwIP reported them. By the time a FIN or
+     * error handler runs, lwIP may have freed the PCB and the client its
+     * context, so those handlers must not rely on the RX buffer or other
+     * connection state: the error is passed as the value, and data still
+     * to be read belongs in the receive handler.
+     */
+    class ScheduledHandler {
+        public:
+            virtual ~ScheduledHandler() = default;
+
+            /**
+             * @param client The client the event belongs to.
+             * @param value err_t for errors, ACKed bytes for ACKs, else 0.
+             */
+            virtual void onEvent(TcpClient &client, int32_t value) = 0;
+    };
+
+    class PriorityScheduler {
+        public:
+            enum class Priority : uint8_t { Critical = 0, Interactive, Bulk };
+
+            static constexpr uint8_t CLASSES = 3;
+
+            struct Stats {
+                    uint32_t dispatched[CLASSES]{};
+                    uint32_t coalesced = 0;
+                    uint32_t dropped = 0; ///< Queue full
+                    uint32_t stale = 0;   ///< Connection gone at dispatch
+                    uint32_t promoted = 0; ///< Data tasks moved to Critical
+                    uint32_t max_depth[CLASSES]{};
+            };
+
+            /**
+             * @param ctx The networking async context (the one lwIP and
+             * the client bridges run on).
+             */
+            explicit PriorityScheduler(async_context_t *ctx);
+            ~PriorityScheduler();
+
+            PriorityScheduler(const PriorityScheduler &) = delete;
+            PriorityScheduler &operator=(const PriorityScheduler &) = delete;
+
+            /**
+             * @brief Queue @p handler for @p client (networking core).
+             * @param coalesce Merge with a queued task of the same handler
+             * and client, adding up @p value.
+             * @param handle Connection the event belongs to; INVALID skips
+             * the staleness check.
+             * @return false if the class queue was full.
+             */
+            bool post(Priority priority, ScheduledHandler *handler,
+                      TcpClient *client, int32_t value, bool coalesce,
+                      ClientHandle handle = HandleTable::INVALID);
+
+            /**
+             * @brief Move @p client's queued Interactive and Bulk tasks, in
+             * order, to the end of the Critical queue, so they run before a
+             * critical task posted next (networking core).
+             * @return false, moving nothing, if Critical lacks room for them
+             * and one more task.
+             */
+            bool promote(const TcpClient *client);
+
+            /**
+             * @brief Table used to drop stale tasks (nullptr disables).
+             */
+            void setHandleTable(const HandleTable *handles) {
+                m_handles = handles;
+            }
+
+            /**
+             * @brief Run, now and in queue order, every queued task of
+             * @p client for @p handler, e.g. its receive handler before the
+             * connection's RX buffer and handle go away (networking core).
+             */
+            void runPending(const TcpClient *client,
+                            const ScheduledHandler *handler);
+
+            /**
+             * @brief Drop every queued task of @p client, e.g. before it is
+             * destroyed (networking core).
+             */
+            void cancel(const TcpClient *client);
+
+            /**
+             * @brief Bulk tasks run per worker pass before yielding.
+             */
+            void setBulkBatch(const uint8_t n) { m_bulk_batch = n ? n : 1; }
+
+            [[nodiscard]] uint8_t bulkBatch() const { return m_bulk_batch; }
+
+            [[nodiscard]] const Stats &stats() const { return m_stats; }
+
+        private:
+            struct Task {
+                    ScheduledHandler *handler;
+                    TcpClient *client;
+                    int32_t value;
+                    ClientHandle handle;
+            };
+
+            struct Queue {
+                    Task tasks[ASYNC_TCP_SCHED_QUEUE]{};
+                    uint8_t head = 0;
+                    uint8_t count = 0;
+            };
+
+            static void s_do_work(async_context_t *ctx,
+                                  async_when_pending_worker_t *worker);
+
+            void drain();
+            bool runOne(Priority priority);
+
+            async_context_t *m_ctx;
+            async_when_pending_worker_t m_worker{};
+            Queue m_queues[CLASSES]{};
+            Stats m_stats{};
+            const HandleTable *m_handles = nullptr;
+            uint8_t m_bulk_batch = 4;
+    };
+
+} // namespace async_tcp
@@ -0,0 +1,85 @@
+/**
+ * @file ReadinessMap.hpp
+ * @brief select()-style readiness bits for up to 32 clients.
+ *
+ * The networking core keeps four bitmaps indexed by client id: readable
+ * (unconsumed RX data), writable (send buffer has room), hangup (FIN
+ * received) and error (tcp_err seen). A fifth word, pending(), is the OR of
+ * readable, hangup and error, so the application core learns which
+ * clients need attention with a single 32-bit read and no round trip.
+ *
+ * The bits are level-triggered. TcpClient callbacks update them on the
+ * networking core, and closing a client (shutdown(), the destructor)
+ * clears its bits from whichever core that runs on, so set() and clear()
+ * serialise on a hardware spin lock held for one read-modify-write; the
+ * Cortex-M0+ has no atomic one. Readers on any core use ready(), pending()
+ * or waitAny() without locking; writers issue __sev() after each update so
+ * waitAny() can sleep in __wfe().
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <hardware/sync.h>
+
+namespace async_tcp {
+
+    class ReadinessMap {
+        public:
+            enum class Kind : uint8_t { Readable = 0, Writable, Hangup, Error };
+
+            static constexpr uint8_t KINDS = 4;
+            static constexpr uint8_t MAX_CLIENTS = 32;
+
+            ReadinessMap();
+            ~ReadinessMap();
+
+            ReadinessMap(const ReadinessMap &) = delete;
+            ReadinessMap &operator=(const ReadinessMap &) = delete;
+
+            /**
+             * @brief Set or clear one bit (either core, not from an ISR).
+             */
+            void set(uint8_t client_id, Kind kind, bool on);
+
+            /**
+             * @brief Clear every bit of @p client_id (either core, not from
+             * an ISR).
+             */
+            void clear(uint8_t client_id);
+
+            /**
+             * @brief Clients with @p kind set, one bit per client id.
+             */
+            [[nodiscard]] uint32_t ready(const Kind kind) const {
+                return m_bits[static_cast<uint8_t>(kind)].load(
+                    std::memory_order_acquire);
+            }
+
+            /**
+             * @brief Clients that are readable, hung up or in error.
+             */
+            [[nodiscard]] uint32_t pending() const {
+                return m_pending.load(std::memory_order_acquire);
+            }
+
+            /**
+             * @brief Wait until a client in @p mask is pending (or also
+             * writable, with @p include_writable), or @p timeout_us passes.
+             * @return The matching client bits, 0 on timeout.
+             * @note Sleeps in __wfe() between checks; do not call from the
+             * networking core, which is the one that wakes it.
+             */
+            [[nodiscard]] uint32_t waitAny(uint32_t mask, uint32_t timeout_us,
+                                           bool include_writable = false) const;
+
+        private:
+            void publish();
+
+            spin_lock_t *m_lock; ///< Serialises writers
+            std::atomic<uint32_t> m_bits[KINDS]{};
+            std::atomic<uint32_t> m_pending{0};
+    };
+
+} // namespace async_tcp
@@ -0,0 +1,110 @@
+/**
+ * @file ScheduledWriter.hpp
+ * @brief Writes pushed out by the networking core at an absolute deadline.
+ *
+ * Issuing write() from the application loop adds that loop's jitter to
+ * every send. ScheduledWriter copies the data into a fixed slot right
+ * away and arms one async_context at-time worker for the earliest
+ * deadline; when it fires, the worker runs tcp_write()/tcp_output() on the
+ * networking core for every write that is due.
+ *
+ * Each send records how late it went out (achieved minus requested time)
+ * in a LatencyHistogram, so scheduling jitter can be read from any core.
+ * Writes whose client has no connection at the deadline, or that do not
+ * fit the send buffer whole, are counted as failed and dropped without
+ * sending any of their bytes.
+ *
+ * schedule() takes the async context lock and may be called from either
+ * core.
+ */
+
+#pragma once
+
+#include "LatencyHistogram.hpp"
+
+#include <Arduino.h>
+#include <cstddef>
+#include <cstdint>
+#include <pico/async_context.h>
+#include <pico/time.h>
+
+#ifndef ASYNC_TCP_SCHED_WRITES
+#define ASYNC_TCP_SCHED_WRITES 8 // pending writes
+#endif
+#ifndef ASYNC_TCP_SCHED_WRITE_BYTES
+#define ASYNC_TCP_SCHED_WRITE_BYTES 128 // payload per write
+#endif
+
+namespace async_tcp {
+
+    class TcpClient;
+
+    class ScheduledWriter {
+        public:
+            struct Stats {
+                    uint32_t scheduled = 0;
+                    uint32_t sent = 0;
+                    uint32_t failed = 0;   ///< No connection or no room
+                    uint32_t rejected = 0; ///< Queue full or payload too big
+                    uint32_t max_late_us = 0;
+            };
+
+            /**
+             * @param ctx The networking async context.
+             */
+            explicit ScheduledWriter(async_context_t *ctx);
+            ~ScheduledWriter();
+
+            ScheduledWriter(const ScheduledWriter &) = delete;
+            ScheduledWriter &operator=(const ScheduledWriter &) = delete;
+
+            /**
+             * @brief Send a copy of @p data on @p client at @p deadline.
+             * @return false if the queue is full or @p size exceeds
+             * ASYNC_TCP_SCHED_WRITE_BYTES.
+             */
+            bool schedule(TcpClient &client, absolute_time_t deadline,
+                          const uint8_t *data, std::size_t size);
+
+            /**
+             * @brief Drop every pending write of @p client.
+             */
+            void cancel(const TcpClient &client);
+
+            /**
+             * @brief Distribution of achieved minus requested send time.
+             */
+            [[nodiscard]] LatencyHistogram::Snapshot jitter() const {
+                return m_jitter.snapshot();
+            }
+
+            [[nodiscard]] Stats stats() const;
+
+            void resetStats();
+
+            void print(Print &out) const;
+
+        private:
+            struct Pending {
+                    TcpClient *client;
+                    uint64_t deadline_us;
+                    uint16_t size;
+                    uint8_t data[ASYNC_TCP_SCHED_WRITE_BYTES];
+            };
+
+            static void s_do_work(async_context_t *ctx,
+                                  async_at_time_worker_t *worker);
+
+            void fire();
+            void arm();
+
+            async_context_t *m_ctx;
+            async_at_time_worker_t m_worker{};
+            Pending m_pending[ASYNC_TCP_SCHED_WRITES]{}; ///< Sorted by deadline
+            uint8_t m_count = 0;
+            bool m_armed = false;
+            Stats m_stats{};
+            LatencyHistogram m_jitter;
+    };
+
+} // namespace async_tcp
@@ -0,0 +1,124 @@
+/**
+ * @file SoakMonitor.hpp
+ * @brief Resource sampling and trend checks for long-running soak tests.
+ *
+ * SoakMonitor samples heap usage, the heap high-water mark, the largest
+ * allocatable block, lwIP memp usage and throughput. Samples
+ * are kept in a fixed array; when it fills up every other sample is
+ * dropped, so any run length is covered at decreasing resolution without
+ * allocating.
+ *
+ * healthy() fits a least-squares line through each metric (after a
+ * warm-up) and fails when it trends the wrong way faster than the
+ * configured limit: heap, high-water mark or memp usage growing, the
+ * largest free block shrinking (fragmentation) or throughput decaying.
+ *
+ * memp figures require LWIP_STATS and MEMP_STATS in lwipopts; without them
+ * they read as zero and never fail.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <cstddef>
+#include <cstdint>
+
+#ifndef ASYNC_TCP_SOAK_SAMPLES
+#define ASYNC_TCP_SOAK_SAMPLES 128
+#endif
+
+namespace async_tcp {
+
+    struct SoakSample {
+            uint32_t t_ms;         ///< millis() at sampling
+            uint32_t heap_used;    ///< Bytes allocated
+            uint32_t heap_peak;    ///< Highest heap_used sampled so far
+            uint32_t largest_free; ///< Largest single allocation possible
+            uint32_t memp_used;    ///< lwIP memp elements in use, all pools
+            uint32_t pbuf_used;    ///< PBUF_POOL elements in use
+            uint32_t bytes_per_s;  ///< Throughput since the previous sample
+    };
+
+    class SoakMonitor {
+        public:
+            enum class Metric : uint8_t {
+                HeapUsed,
+                HeapPeak,
+                LargestFree,
+                MempUsed,
+                PbufUsed,
+                Throughput
+            };
+
+            /**
+             * @brief Allowed drift per hour. Percentages are relative to the
+             * metric's mean over the evaluated window; memp/pbuf limits are
+             * absolute element counts.
+             */
+            struct Limits {
+                    float heap_growth_pct = 2.0f;
+                    float peak_growth_pct = 1.0f;
+                    float block_shrink_pct = 2.0f;
+                    float memp_growth = 1.0f;
+                    float pbuf_growth = 1.0f;
+                    float throughput_decay_pct = 5.0f;
+                    uint16_t warmup_samples = 4;
+            };
+
+            SoakMonitor();
+            explicit SoakMonitor(const Limits &limits);
+
+            /**
+             * @brief Take a sample.
+             * @param bytes_total Cumulative bytes moved by the workload.
+             */
+            const SoakSample &sample(uint64_t bytes_total);
+
+            /**
+             * @brief Least-squares slope of @p metric, in units per hour.
+             */
+            [[nodiscard]] float slopePerHour(Metric metric) const;
+
+            /**
+             * @brief true while no metric drifts beyond its limit.
+             */
+            [[nodiscard]] bool healthy() const;
+
+            /**
+             * @brief Print the latest sample and each metric's trend.
+             */
+            void report(Print &out) const;
+
+            [[nodiscard]] std::size_t size() const { return m_count; }
+
+            [[nodiscard]] const SoakSample &last() const {
+                return m_samples[m_count ? m_count - 1 : 0];
+            }
+
+            /**
+             * @brief Largest block malloc() can currently return.
+             *
+             * Probes with a binary search of malloc/free pairs, so it costs
+             * ~20 allocations; call it at sampling rate only.
+             */
+            static uint32_t largestFreeBlock();
+
+            static uint32_t mempUsed();
+
+            static uint32_t pbufPoolUsed();
+
+        private:
+            [[nodiscard]] float value(const SoakSample &s, Metric m) const;
+            [[nodiscard]] bool drifts(Metric metric) const;
+            void decimate();
+
+            Limits m_limits;
+            SoakSample m_samples[ASYNC_TCP_SOAK_SAMPLES]{};
+            std::size_t m_count = 0;
+            std::size_t m_total = 0;
+            uint64_t m_last_bytes = 0;
+            uint32_t m_last_t_ms = 0; ///< Time of the previous sample() call
+            uint32_t m_heap_peak = 0;
+    };
+
+} // namespace async_tcp
@@ -0,0 +1,117 @@
+/**
+ * @file StageTimings.hpp
+ * @brief Per-connection latency breakdown of the RX and TX data paths.
+ *
+ * StageTimings timestamps each stage a byte passes through and aggregates
+ * the deltas into one histogram per stage:
+ *
+ *  RX: pbuf arrival in lwip_receive_callback -> handler start (first peek
+ *      after arrival, i.e. once the bridge has dispatched the handler) ->
+ *      peekConsume() -> tcp_recved() done.
+ *  TX: TcpWriter::writeData() call -> last tcp_write() -> tcp_output() ->
+ *      the ACK covering the write in lwip_sent_cb.
+ *
+ * ACKs are matched to writes through a small FIFO of cumulative end
+ * offsets. Only writes made through TcpWriter are tracked; data written
+ * with TcpClientContext::writeChunk() would shift the offsets, so timing
+ * and writeChunk() should not be mixed on one connection.
+ *
+ * The hooks run on the networking core only. Each stage is a
+ * LatencyHistogram, so snapshot() returns a consistent copy on any core.
+ */
+
+#pragma once
+
+#include "LatencyHistogram.hpp"
+
+#include <Arduino.h>
+#include <cstddef>
+#include <cstdint>
+
+#ifndef ASYNC_TCP_STAGE_TX_FIFO
+#define ASYNC_TCP_STAGE_TX_FIFO 16 // writes awaiting their ACK
+#endif
+
+namespace async_tcp {
+
+    class StageTimings {
+        public:
+            enum class Stage : uint8_t {
+                RxArrivalToHandler = 0,
+                RxHandlerToConsume,
+                RxConsumeToRecved,
+                RxArrivalToRecved,
+                TxWriteToEnqueue,
+                TxEnqueueToOutput,
+                TxOutputToAck,
+                TxWriteToAck,
+                Count
+            };
+
+            static constexpr std::size_t STAGES =
+                static_cast<std::size_t>(Stage::Count);
+
+            static const char *name(Stage stage);
+
+            // --- Hooks (networking core) ---
+
+            void rxArrival();
+
+            void rxHandlerStart();
+
+            /**
+             * @param t_consume time_us_32() at peekConsume() entry
+             * @param drained true when the receive chain is now empty
+             */
+            void rxConsumed(uint32_t t_consume, bool drained);
+
+            /**
+             * @param t_write time_us_32() at writeData() entry
+             * @param t_enqueued after the last tcp_write()
+             * @param queued bytes queued by this write
+             */
+            void txWritten(uint32_t t_write, uint32_t t_enqueued,
+                           std::size_t queued);
+
+            void txAcked(uint16_t len);
+
+            // --- Readers (any core) ---
+
+            [[nodiscard]] LatencyHistogram::Snapshot
+            snapshot(Stage stage) const;
+
+            /// Writes dropped from timing because the FIFO was full.
+            [[nodiscard]] uint32_t txUntracked() const {
+                return m_tx_untracked;
+            }
+
+            /**
+             * @brief Clear all histograms and pending state (networking core).
+             */
+            void reset();
+
+            void print(Print &out) const;
+
+        private:
+            struct PendingWrite {
+                    uint32_t end;      ///< Cumulative offset after the write
+                    uint32_t t_write;  ///< writeData() entry
+                    uint32_t t_output; ///< tcp_output() returned
+            };
+
+            void record(Stage stage, uint32_t us);
+
+            LatencyHistogram m_hist[STAGES];
+
+            uint32_t m_rx_arrival = 0; ///< 0 = no unhandled data
+            uint32_t m_rx_handler = 0; ///< 0 = handler not started
+
+            PendingWrite m_tx_fifo[ASYNC_TCP_STAGE_TX_FIFO]{};
+            uint8_t m_tx_head = 0;
+            uint8_t m_tx_count = 0;
+            uint32_t m_tx_queued = 0; ///< Cumulative bytes queued (wraps)
+            uint32_t m_tx_acked = 0;  ///< Cumulative bytes ACKed (wraps)
+            uint32_t m_tx_untracked = 0;
+    };
+
+} // namespace async_tcp
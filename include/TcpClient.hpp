@@ -33,6 +33,10 @@
  */
 #pragma once
 
+#include "CompletionQueue.hpp"
+#include "EpochReclaimer.hpp"
+#include "PriorityScheduler.hpp"
+#include "ReadinessMap.hpp"
 #include "WiFi.h"
 
 namespace async_bridge {
@@ -51,9 +55,18 @@ namespace async_tcp {
 #define TCP_DEFAULT_KEEP_ALIVE_INTERVAL_SEC 75 // 75 sec
 #define TCP_DEFAULT_KEEP_ALIVE_COUNT 9         // fault after 9 failures
 
+#ifndef ASYNC_TCP_STALL_POLL
+#define ASYNC_TCP_STALL_POLL 0 // 500 ms ticks between stall polls, 0 = off
+#endif
+
     class TcpClientContext;
     class TcpClientSyncAccessor;
     class TcpWriter;
+    class StageTimings;
+    class AdaptiveNagle;
+    class TxBudget;
+    class ScheduledWriter;
+    class AckAggregator;
 
     using namespace std::placeholders;
     using namespace async_bridge;
@@ -63,6 +76,31 @@ namespace async_tcp {
     //  Local alias for arduino::String
     using AString = String;
 
+    /**
+     * @brief Cumulative per-client counters, kept across reconnects.
+     */
+    struct TcpClientCounters {
+            uint32_t connects = 0;
+            uint32_t fins = 0;
+            uint32_t errors = 0;
+            uint32_t polls = 0;  ///< While the poll has a consumer, else
+                                 ///< every ASYNC_TCP_STALL_POLL ticks if set
+            uint32_t stalls = 0; ///< Polls with data in flight and no ACK since
+            uint64_t rx_bytes = 0;
+            uint64_t tx_bytes = 0; ///< Queued with tcp_write()
+            uint64_t tx_acked_bytes = 0;
+    };
+
+    /**
+     * @brief Live connection figures read without the context lock.
+     */
+    struct TcpClientLiveStats {
+            uint8_t state = 0; ///< Cached tcp_state, CLOSED without a connection
+            uint64_t rx_bytes = 0; ///< Received on the live connection
+            uint64_t tx_queued_bytes = 0;
+            uint64_t tx_acked_bytes = 0;
+    };
+
     using TcpClientSyncAccessorPtr = std::unique_ptr<TcpClientSyncAccessor>;
     using PerpetualBridgePtr = std::unique_ptr<PerpetualBridge>;
 
@@ -202,14 +240,12 @@ namespace async_tcp {
              *
              * @param data Pointer to binary data to write
              * @param size Size of data chunk
+             * @return Bytes queued; 0 when there is no room yet (would
+             * block) or on error.
              */
-            void writeChunk(const uint8_t* data, size_t size) const;
+            std::size_t writeChunk(const uint8_t* data, size_t size) const;
 
-            void stop() const {
-                if (const auto err = stop(0); err == false) {
-                    DEBUGWIRE("[:i%d] :stop timeout\n", getClientId());
-                }
-            }
+            void stop() const;
 
             [[nodiscard]] bool stop(unsigned int maxWaitMs) const;
 
@@ -239,6 +275,8 @@ namespace async_tcp {
             }
 
             friend class TcpClientSyncAccessor;
+            friend class ScheduledWriter;
+            friend class AckAggregator;
 
             void
             keepAlive(uint16_t idle_sec = TCP_DEFAULT_KEEP_ALIVE_IDLE_SEC,
@@ -309,6 +347,184 @@ namespace async_tcp {
                 return m_sync_accessor.get();
             }
 
+            /**
+             * @brief Turn the per-connection RX/TX stage latency breakdown
+             * on or off. Timings persist across reconnects until disabled.
+             * Call from the networking core (e.g. in a handler or before
+             * connect()).
+             */
+            void enableStageTimings(bool enable);
+
+            /**
+             * @brief Stage histograms, or nullptr when timing is disabled.
+             * The histograms may be read from any core.
+             */
+            [[nodiscard]] const StageTimings *getStageTimings() const {
+                return m_stage_timings.get();
+            }
+
+            /**
+             * @brief Switch Nagle per write from observed sizes and gaps
+             * instead of the static setNoDelay() setting. Disabling restores
+             * the last setNoDelay() value of this connection. The state persists across
+             * reconnects. Call from the networking core.
+             */
+            void enableAdaptiveNoDelay(bool enable);
+
+            /**
+             * @brief Adaptive state and decision history, or nullptr when
+             * adaptive mode is off. Read on the networking core.
+             */
+            [[nodiscard]] const AdaptiveNagle *getAdaptiveNagle() const {
+                return m_adaptive_nagle.get();
+            }
+
+            /**
+             * @brief Counters including the live connection. Call from the
+             * networking core.
+             */
+            [[nodiscard]] TcpClientCounters getCounters() const;
+
+            /**
+             * @brief Register in @p handles; the handle is renewed on every
+             * connect and close, so events captured with getHandle() can be
+             * checked for staleness. Call from the networking core, before
+             * connect(), and keep the table alive longer than the client.
+             */
+            void setHandleTable(HandleTable *handles);
+
+            /**
+             * @brief Handle of the current connection (any core), or
+             * HandleTable::INVALID without a table.
+             */
+            [[nodiscard]] ClientHandle getHandle() const {
+                return m_handle.load(std::memory_order_acquire);
+            }
+
+            /**
+             * @brief Share @p budget with other clients at @p weight (e.g.
+             * 4 interactive, 1 bulk); nullptr stops. Takes effect on the
+             * next connect(). Call from the networking core.
+             */
+            void setTxBudget(TxBudget *budget, const uint8_t weight = 1) {
+                m_tx_budget = budget;
+                m_tx_weight = weight;
+            }
+
+            /**
+             * @brief Writer used by writeAt() (nullptr disables). Keep it
+             * alive longer than the client.
+             */
+            void setScheduledWriter(ScheduledWriter *writer) {
+                m_scheduled_writer = writer;
+            }
+
+            /**
+             * @brief Send a copy of @p buf at @p deadline from the
+             * networking core (any core may call this). Achieved vs
+             * requested send times are in the ScheduledWriter's jitter().
+             * @return false without a ScheduledWriter, or if it is full.
+             */
+            bool writeAt(absolute_time_t deadline, const uint8_t *buf,
+                         std::size_t size);
+
+            /**
+             * @brief Batch ACK notifications through @p aggregator (nullptr
+             * runs the ACK bridge or handler once per lwIP sent callback).
+             * Keep it alive longer than the client. Call from the
+             * networking core.
+             */
+            void setAckAggregator(AckAggregator *aggregator);
+
+            /**
+             * @brief ACKed bytes not yet delivered by the AckAggregator;
+             * they will not be notified again. Any core may call this.
+             */
+            uint32_t takeAckedBytes() {
+                return m_ack_pending.exchange(0, std::memory_order_relaxed);
+            }
+
+            /**
+             * @brief Retire closed contexts through @p reclaimer instead of
+             * deleting them, so liveStats() can read them from any core
+             * (nullptr deletes immediately). Give @p reclaimer the
+             * networking context (EpochReclaimer::setContext()) so contexts
+             * retired during a guard are freed without waiting for the next
+             * close. Call from the networking core, before connect().
+             */
+            void setReclaimer(EpochReclaimer *reclaimer) {
+                m_reclaimer = reclaimer;
+            }
+
+            /**
+             * @brief State and byte counts of the live connection, from any
+             * core without execute_sync. Requires setReclaimer(); returns
+             * only the cached state otherwise. Counters may lag the
+             * networking core by a callback.
+             */
+            [[nodiscard]] TcpClientLiveStats liveStats() const;
+
+            /**
+             * @brief Publish this client's readable/writable/hangup/error
+             * state into @p map under its client id (< 32); nullptr stops.
+             * Call from the networking core, before connect().
+             */
+            void setReadinessMap(ReadinessMap *map) { m_readiness = map; }
+
+            /**
+             * @brief Post connect, readable, write-ACKed, FIN and error
+             * completions into @p queue (nullptr stops). Registered bridges
+             * still run; leave them unset for pure completion-queue mode.
+             * Call from the networking core, before connect().
+             */
+            void setCompletionQueue(CompletionQueue *queue) {
+                m_completions = queue;
+            }
+
+            /**
+             * @brief Events that can be dispatched through a
+             * PriorityScheduler instead of a bridge.
+             */
+            enum class ScheduledEvent : uint8_t {
+                Connected = 0,
+                Received,
+                Fin,
+                Error,
+                Ack,
+                Poll,
+            };
+
+            /**
+             * @brief Dispatch events with a ScheduledHandler through
+             * @p scheduler (nullptr stops). Connected, FIN and error run as
+             * Critical; received, ACK and poll at @p data_priority, so
+             * latency-sensitive clients can use Interactive and bulk
+             * transfers Bulk. Events without a scheduled handler still go
+             * to their bridge. Call from the networking core, before
+             * connect(). With a scheduler, call shutdown() from the
+             * networking core too: it first runs receive tasks still queued.
+             */
+            void setScheduler(PriorityScheduler *scheduler,
+                              const PriorityScheduler::Priority data_priority =
+                                  PriorityScheduler::Priority::Bulk) {
+                m_scheduler = scheduler;
+                m_data_priority = data_priority;
+            }
+
+            /**
+             * @brief Handler run by the scheduler for @p event (nullptr
+             * falls back to the bridge). The error value is the err_t, the
+             * ACK value the ACKed byte count. FIN and error handlers may run
+             * after the connection is gone; see ScheduledHandler.
+             */
+            void setScheduledHandler(ScheduledEvent event,
+                                     ScheduledHandler *handler) {
+                m_scheduled[static_cast<uint8_t>(event)] = handler;
+                if (event == ScheduledEvent::Poll && _ctx) {
+                    _applyPollCallback();
+                }
+            }
+
             /**
              * @brief Get the client ID (for internal logging)
              * @return uint8_t client id
@@ -327,6 +543,29 @@ namespace async_tcp {
 
             static uint16_t _localPort;
             TcpClientSyncAccessorPtr m_sync_accessor {}; ///< Sync accessor for thread-safe operations
+            std::unique_ptr<StageTimings> m_stage_timings{}; ///< Null = timing disabled
+            std::unique_ptr<AdaptiveNagle> m_adaptive_nagle{}; ///< Null = static no-delay
+            mutable bool m_no_delay = true; ///< Last setNoDelay() value
+            mutable TcpClientCounters m_counters{}; ///< Closed connections plus callback counts
+            mutable std::size_t m_poll_acked = 0; ///< ACKed bytes at the last poll
+            ReadinessMap *m_readiness = nullptr; ///< Optional, not owned
+            CompletionQueue *m_completions = nullptr; ///< Optional, not owned
+            mutable uint64_t m_rx_posted = 0; ///< RX total at the last Readable
+            PriorityScheduler *m_scheduler = nullptr; ///< Optional, not owned
+            EpochReclaimer *m_reclaimer = nullptr; ///< Optional, not owned
+            HandleTable *m_handles = nullptr; ///< Optional, not owned
+            TxBudget *m_tx_budget = nullptr; ///< Optional, not owned
+            ScheduledWriter *m_scheduled_writer = nullptr; ///< Optional, not owned
+            AckAggregator *m_ack_aggregator = nullptr; ///< Optional, not owned
+            std::atomic<uint32_t> m_ack_pending{0}; ///< ACKed, not yet notified
+            bool m_ack_dirty = false; ///< On the aggregator's pending list
+            uint8_t m_tx_weight = 1;
+            std::atomic<ClientHandle> m_handle{HandleTable::INVALID};
+            std::atomic<TcpClientContext *> m_shared_ctx{nullptr}; ///< _ctx for lock-free readers
+            mutable std::atomic<uint8_t> m_state{CLOSED}; ///< Cached for lock-free readers
+            PriorityScheduler::Priority m_data_priority =
+                PriorityScheduler::Priority::Bulk;
+            ScheduledHandler *m_scheduled[6]{}; ///< By ScheduledEvent
 
             // --- Client ID for logging and traceability ---
             uint8_t m_client_id = 0; // Smallest integer type for client id
@@ -339,15 +578,46 @@ namespace async_tcp {
 
             void _onReceiveCallback() const;
 
-            void _onAckCallback(const tcp_pcb *tpcb, uint16_t len) const;
+            void _onAckCallback(const tcp_pcb *tpcb, uint16_t len);
+
+            void _dispatchAck(uint16_t len) const;
 
             void _onPollCallback() const;
 
+            void _applyPollCallback() const;
+
+            void _deleteContext();
+
+            void _setReady(const ReadinessMap::Kind kind, const bool on) const {
+                if (m_readiness) {
+                    m_readiness->set(getClientId(), kind, on);
+                }
+            }
+
+            void _updateWritable() const;
+
+            void _renewHandle();
+
+            /**
+             * @brief Queue @p event on the scheduler.
+             * @return false if the bridge should handle it instead.
+             */
+            bool _schedule(ScheduledEvent event, int32_t value) const;
+
+            void _post(const Completion::Type type, const int32_t value) const {
+                if (m_completions) {
+                    m_completions->post(type, getClientId(), value,
+                                        getHandle());
+                }
+            }
+
         private:
             unsigned long _timeout;      // number of milliseconds to wait for the next char before aborting timed read
             WriteCallback m_write_callback = {}; ///< Callback for handling write operations
 
             virtual uint8_t _ts_status();
+            // The TcpWriter, created on first use (networking core)
+            TcpWriter *_ts_txWriter() const;
             // Thread-context correct connect implementation (must be called under async-context lock on networking core)
             virtual int _ts_connect(AIPAddress ip, uint16_t port);
 
@@ -21,6 +21,7 @@
 
 #pragma once
 
+#include "EventRecorder.hpp"
 #include "IoRxBuffer.hpp"
 #include "TcpWriter.hpp"
 
@@ -31,6 +32,7 @@
 #include <lwip/opt.h>
 #include <lwip/tcp.h>
 #include <memory>
+#include <pico/time.h>
 
 namespace async_tcp {
 
@@ -54,17 +56,24 @@ namespace async_tcp {
     using error_cb_t = std::function<void(err_t err)>;
 
     class TcpClientContext {
+            friend class EventReplayer;
+
         public:
+            /**
+             * Only tcp_recv and tcp_err are registered up front: lwIP's
+             * default receive handler would close the PCB on FIN behind our
+             * back. The IoRxBuffer is allocated when the first segment or
+             * FIN arrives, the TcpWriter (and with it tcp_sent) on the
+             * first getTxWriter(), and tcp_poll only while a poll callback
+             * is set. Send-only and receive-only clients never pay for the
+             * other direction.
+             */
             explicit TcpClientContext(tcp_pcb *pcb)
                 : _pcb(pcb) {
                 tcp_setprio(_pcb, TCP_PRIO_MIN);
                 tcp_arg(_pcb, this);
                 tcp_recv(_pcb, lwip_receive_callback);
-                tcp_sent(_pcb, lwip_sent_cb);
                 tcp_err(_pcb, &_s_error);
-                tcp_poll(_pcb, reinterpret_cast<tcp_poll_fn>(&_s_poll), 1);
-                initRxBuffer();
-                initTxWriter(pcb);
             }
 
             err_t abort() {
@@ -230,40 +239,61 @@ namespace async_tcp {
              *
              * @param data Pointer to binary data to write
              * @param size Size of data chunk
+             * @return Bytes queued, at most @p size. 0 with no error callback
+             * when the send buffer or TX budget is full (would block); retry
+             * after an ACK.
              */
-            void writeChunk(const uint8_t *data, const size_t size) const {
+            std::size_t writeChunk(const uint8_t *data, const size_t size) {
                 if (!_pcb) {
                     // No PCB — connection not established or closed
                     _errorCb(ERR_CONN);
-                    return;
+                    return 0;
                 }
 
                 if (!data || size == 0) {
                     // Invalid parameters
                     _errorCb(PICO_ERROR_INVALID_ARG);
-                    return;
+                    return 0;
                 }
 
-                // Calculate chunk size.
-                const auto sbuf = static_cast<size_t>(tcp_sndbuf(_pcb));
+                // Calculate chunk size (within the writer's TX budget share).
+                TcpWriter *tx = getTxWriter();
+                if (_nagle) {
+                    tx->observeWrite(size, time_us_32());
+                }
+                const auto sbuf = tx->availableForWrite();
                 const auto chunk_size = std::min(sbuf, size);
 
                 if (chunk_size == 0) {
-                    // Buffer space not available — this constitutes an ERR_MEM
-                    // condition.
-                    _errorCb(ERR_MEM);
-                    return;
+                    // No room in the send buffer or budget share: would
+                    // block, not an error.
+                    if (_writtenCb) {
+                        _writtenCb(0);
+                    }
+                    return 0;
                 }
 
                 // Direct tcp_write call
                 if (const auto err = tcp_write(_pcb, data, chunk_size, 0);
                     err != ERR_OK) {
-                    // Error — notify integration layer via callback
-                    _errorCb(err);
-                    return;
+                    if (err == ERR_MEM) {
+                        // lwIP's segment queue is full: also would block.
+                        if (_writtenCb) {
+                            _writtenCb(0);
+                        }
+                    } else {
+                        // Error — notify integration layer via callback
+                        _errorCb(err);
+                    }
+                    return 0;
                 }
+                tx->noteQueued(chunk_size);
 
                 tcp_output(_pcb); // Ensure data is sent immediately
+                if (_writtenCb) {
+                    _writtenCb(chunk_size);
+                }
+                return chunk_size;
             }
 
             void keepAlive(
@@ -306,18 +336,51 @@ namespace async_tcp {
                 _errorCb = cb;
             }
 
+            /**
+             * @brief Whether lwIP reported a fatal error (tcp_err). Write
+             * errors reported through the error callback leave it false.
+             */
+            [[nodiscard]] bool failed() const { return _failed; }
+
             void setOnAckCallback(const std::function<void(struct tcp_pcb *tpcb,
                                                            uint16_t len)> &cb) {
                 _ackCb = cb;
+                // initTxWriter() applies it to a writer created later.
+                if (_tx) {
+                    _tx->setOnAckCallback(_ackCb);
+                }
             }
 
+            /**
+             * @brief Called on the networking core after every write
+             * (writeChunk() or TcpWriter::writeData()) with the bytes
+             * queued, 0 when rejected.
+             */
             void setOnWrittenCallback(
                 const std::function<void(size_t bytes_written)> &cb) {
                 _writtenCb = cb;
+                if (_tx) {
+                    _tx->setOnWrittenCallback(_writtenCb);
+                }
             }
 
-            void setOnPollCallback(const std::function<void()> &cb) {
+            /**
+             * @brief Set (or clear with an empty function) the poll
+             * callback, run every @p interval coarse timer ticks (500 ms
+             * each); tcp_poll is registered only while one is set.
+             */
+            void setOnPollCallback(const std::function<void()> &cb,
+                                   const uint8_t interval = 1) {
                 _pollCb = cb;
+                if (_pcb) {
+                    if (_pollCb) {
+                        tcp_poll(_pcb,
+                                 reinterpret_cast<tcp_poll_fn>(&_s_poll),
+                                 interval);
+                    } else {
+                        tcp_poll(_pcb, nullptr, 0);
+                    }
+                }
             }
 
             void setOnFinCallback(const std::function<void()> &cb) {
@@ -328,6 +391,13 @@ namespace async_tcp {
                 _receiveCb = cb;
             }
 
+            void setOnDrainedCallback(const std::function<void()> &cb) {
+                _drainedCb = cb;
+                if (_rx) {
+                    _rx->setOnDrainedCallback(_drainedCb);
+                }
+            }
+
             /**
              * @brief Set the client ID for this TcpClientContext instance.
              * @param id The client ID to assign (uint8_t)
@@ -336,20 +406,25 @@ namespace async_tcp {
 
             /**
              * @brief Get the IoRxBuffer owned by this context
-             * @return IoRxBuffer* pointer to the receive buffer
+             * @return IoRxBuffer* pointer to the receive buffer, nullptr
+             * until the peer has sent data or FIN
              */
             [[nodiscard]] IoRxBuffer* getRxBuffer() const { return _rx; }
 
             /**
-             * @brief Initialize the IoRxBuffer for this context
+             * @brief Initialize the IoRxBuffer for this context (on the
+             * first receive event)
              */
-            void initRxBuffer() {
+            IoRxBuffer *initRxBuffer() {
                 if (!_rx) {
                     _rx = new IoRxBuffer(nullptr);
                     _rx->setOnFinCallback([this] { _finCb(); });
                     _rx->setOnReceivedCallback(
                                 [this] { _receiveCb(); });
+                    _rx->setOnDrainedCallback(_drainedCb);
+                    _rx->setStageTimings(_timings);
                 }
+                return _rx;
             }
 
             /**
@@ -362,12 +437,21 @@ namespace async_tcp {
             }
 
             /**
-             * @brief Initialize the IoTxWriter for this context
-             * @param pcb
+             * @brief Initialize the IoTxWriter for this context and start
+             * taking ACK callbacks
              */
-            void initTxWriter(tcp_pcb *pcb) {
-                _tx = new TcpWriter(pcb);
+            void initTxWriter() {
+                _tx = new TcpWriter(_pcb);
                 _tx->setOnAckCallback(_ackCb);
+                _tx->setOnWrittenCallback(_writtenCb);
+                _tx->setStageTimings(_timings);
+                _tx->setAdaptiveNagle(_nagle);
+                if (_budget) {
+                    _tx->setTxBudget(_budget, _budget_weight);
+                }
+                if (_pcb) {
+                    tcp_sent(_pcb, lwip_sent_cb);
+                }
             }
 
             /**
@@ -384,7 +468,65 @@ namespace async_tcp {
              */
             [[nodiscard]] uint8_t getClientId() const { return m_client_id; }
 
-            [[nodiscard]] TcpWriter *getTxWriter() const { return _tx; }
+            /**
+             * @brief The TcpWriter, created on first use (write paths,
+             * networking core).
+             */
+            [[nodiscard]] TcpWriter *getTxWriter() {
+                if (!_tx) {
+                    initTxWriter();
+                }
+                return _tx;
+            }
+
+            /**
+             * @brief The TcpWriter if one exists; for statistics and other
+             * readers that must not create it.
+             */
+            [[nodiscard]] TcpWriter *peekTxWriter() const { return _tx; }
+
+            /**
+             * @brief Whether a write would find room now, without creating
+             * the writer.
+             */
+            [[nodiscard]] bool canWriteNow() const {
+                if (_tx) {
+                    return _tx->canWriteNow();
+                }
+                return _pcb && tcp_sndbuf(_pcb) > 0;
+            }
+
+            /**
+             * @brief Attach (or detach with nullptr) stage timing to the RX
+             * buffer and TX writer. Call from the networking core.
+             */
+            void setStageTimings(StageTimings *timings) {
+                _timings = timings;
+                if (_rx) {
+                    _rx->setStageTimings(timings);
+                }
+                if (_tx) {
+                    _tx->setStageTimings(timings);
+                }
+            }
+
+            void setAdaptiveNagle(AdaptiveNagle *nagle) {
+                _nagle = nagle;
+                if (_tx) {
+                    _tx->setAdaptiveNagle(nagle);
+                }
+            }
+
+            /**
+             * @brief TX budget for the writer, applied when it is created.
+             */
+            void setTxBudget(TxBudget *budget, const uint8_t weight) {
+                _budget = budget;
+                _budget_weight = weight;
+                if (_tx) {
+                    _tx->setTxBudget(budget, weight);
+                }
+            }
 
 
         protected:
@@ -479,6 +621,7 @@ namespace async_tcp {
 
                 // Mark connection as in error state but preserve PCB reference
                 // until proper cleanup can be coordinated
+                _failed = true;
 
                 _errorCb(err);
             }
@@ -516,6 +659,7 @@ namespace async_tcp {
             static void _s_error(void *arg, const err_t err) {
                 if (arg) {
                     const auto *ctx = static_cast<TcpClientContext *>(arg);
+                    ASYNC_TCP_RECORD_ERR(Error, ctx->getClientId(), err);
                     const_cast<TcpClientContext*>(ctx)->_error(err);
                 }
             }
@@ -524,6 +668,7 @@ namespace async_tcp {
                                  const tcp_pcb *tpcb) {
                 if (arg) {
                     const auto *ctx = static_cast<TcpClientContext *>(arg);
+                    ASYNC_TCP_RECORD(Poll, ctx->getClientId(), 0);
                     return ctx->_poll(tpcb);
                 }
                 return ERR_OK;
@@ -533,6 +678,7 @@ namespace async_tcp {
                                       const err_t err) {
                 if (arg) {
                     const auto *ctx = static_cast<TcpClientContext *>(arg);
+                    ASYNC_TCP_RECORD_ERR(Connected, ctx->getClientId(), err);
                     return ctx->_connected(pcb, err);
                 }
                 return ERR_OK;
@@ -548,11 +694,19 @@ namespace async_tcp {
             std::function<void()> _finCb;
             std::function<void()> _connectCb;
             error_cb_t _errorCb;
+            bool _failed = false; ///< Set by tcp_err; the PCB is gone
             received_callback_t _receiveCb;
             std::function<void(struct tcp_pcb *tpcb, uint16_t len)> _ackCb;
             std::function<void()> _closeCb;
             std::function<void(size_t bytes_written)> _writtenCb;
             std::function<void()> _pollCb;
+            std::function<void()> _drainedCb;
+
+            // Applied to the RX buffer / TX writer when they are created.
+            StageTimings *_timings = nullptr;
+            AdaptiveNagle *_nagle = nullptr;
+            TxBudget *_budget = nullptr;
+            uint8_t _budget_weight = 1;
 
             // --- Client ID for logging and traceability ---
             uint8_t m_client_id = 0; // Smallest integer type for client ID
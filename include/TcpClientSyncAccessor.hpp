@@ -5,12 +5,14 @@
 #include <cassert>
 
 #include "iprs_util.hpp"
+#include "MagazineAllocator.hpp"
 #include "WiFi.h"  // For IPAddress
 
 namespace async_tcp {
 
     using namespace async_bridge;
     class TcpClient;
+    class TcpWriter;
     using AIPAddress = IPAddress;  // Local alias for IPAddress
 
     class TcpClientSyncAccessor final : public SyncBridge {
@@ -35,6 +37,10 @@ namespace async_tcp {
             // Blocking, thread-safe connect() call
             int connect(const AIPAddress &ip, uint16_t port);
 
+            // Blocking, thread-safe: the TcpWriter, created on first use on
+            // the networking core; nullptr without a connection
+            TcpWriter *txWriter();
+
             // Generic same-core execution helper (prohibits cross-core)
             template <typename F> uint32_t run_local(F &&callMe) {
                 verify_execution_context();
@@ -52,11 +58,14 @@ namespace async_tcp {
             void workload(void *data) override {/* No workload data needed */ };
 
         private:
-            // Payload for accessor operations
-            struct AccessorPayload final : SyncPayload {
+            // Payload for accessor operations; allocated on the calling
+            // core and freed on the networking core, so it comes from the
+            // per-core magazines instead of the heap.
+            struct AccessorPayload final : SyncPayload, MagazineAllocated {
                 enum Operation {
-                    STATUS, ///< Get the TCP client status
-                    CONNECT ///< Connect to remote host
+                    STATUS,   ///< Get the TCP client status
+                    CONNECT,  ///< Connect to remote host
+                    TX_WRITER ///< Get (creating) the TcpWriter
                 };
 
                 Operation op;            ///< The operation to perform
@@ -67,6 +76,8 @@ namespace async_tcp {
                 uint16_t port = 0;            ///< Port for connect
                 int *connect_result = nullptr; ///< Connect result storage
 
+                TcpWriter **writer_ptr = nullptr; ///< Result (TX_WRITER)
+
                 AccessorPayload() : op(STATUS) {}
             };
 
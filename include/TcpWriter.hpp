@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include "TxBudget.hpp"
 
 #include <Arduino.h>
 #include <cstring>
@@ -29,6 +30,8 @@
 namespace async_tcp {
 
     class TcpClient;
+    class StageTimings;
+    class AdaptiveNagle;
 
     extern "C" err_t lwip_sent_cb(void *arg, tcp_pcb *tpcb,
                                   u16_t len); // pure C ACK bridge
@@ -46,6 +49,7 @@ namespace async_tcp {
     class TcpWriter final {
 
             using AckCallback = std::function<void(tcp_pcb *, std::size_t)>;
+            using WrittenCallback = std::function<void(std::size_t)>;
 
             tcp_pcb *m_pcb = nullptr; ///< Pointer to the TCP PCB
             friend err_t lwip_sent_cb(void *arg, tcp_pcb *tpcb, u16_t len);
@@ -84,6 +88,13 @@ namespace async_tcp {
                 CompletionMode::Acked; ///< Current completion policy
 
             AckCallback m_ack_cb; // optional external ACK observer
+            WrittenCallback m_written_cb; // optional, after each writeData()
+
+            StageTimings *m_timings = nullptr; ///< Stage timing, null = off
+            AdaptiveNagle *m_nagle = nullptr;  ///< Adaptive no-delay, null = off
+
+            TxBudget *m_budget = nullptr;               ///< Shared, not owned
+            TxBudget::Account *m_budget_account = nullptr; ///< Our share
 
             /**
              * @brief Determine the size of the next chunk to send. Uses the
@@ -109,9 +120,6 @@ namespace async_tcp {
                 return m_data.get() + size;
             }
 
-            [[nodiscard]] std::size_t availableForWrite() const;
-
-
         public:
             /**
              * @brief Constructor for TcpWriter
@@ -120,17 +128,21 @@ namespace async_tcp {
             explicit TcpWriter(tcp_pcb *pcb);
 
             /**
-             * @brief Destructor
+             * @brief Destructor; returns any budget still held.
              */
-            ~TcpWriter() = default;
+            ~TcpWriter() { setTxBudget(nullptr, 0); }
 
             /**
              * @brief Write data directly to TCP without buffer management
              * @param data Pointer to data buffer (owned by caller)
              * @param size Size of data to write
+             * @param copy Let lwIP copy the data (TCP_WRITE_FLAG_COPY).
+             * Without it lwIP sends and retransmits from @p data, which must
+             * then stay unchanged until ACKed.
              * @return Number of bytes successfully queued
              */
-            std::size_t writeData(const uint8_t *data, std::size_t size);
+            std::size_t writeData(const uint8_t *data, std::size_t size,
+                                  bool copy = false);
 
             /**
              * @brief Get optimal chunk size for current send buffer state
@@ -144,6 +156,32 @@ namespace async_tcp {
                                 static_cast<std::size_t>(TCP_MSS));
             }
 
+            /**
+             * @brief Bytes that may be queued now: the TCP send buffer,
+             * capped by the TX budget share when one is attached.
+             */
+            [[nodiscard]] std::size_t availableForWrite() const;
+
+            /**
+             * @brief Account @p bytes queued with tcp_write() outside
+             * writeData() (e.g. TcpClientContext::writeChunk).
+             */
+            void noteQueued(std::size_t bytes);
+
+            /**
+             * @brief Feed a write of @p size bytes at @p t_us to adaptive
+             * Nagle, if attached, and set the PCB's flag from it. Called by
+             * writeData() and by writers that bypass it.
+             */
+            void observeWrite(std::size_t size, uint32_t t_us);
+
+            /**
+             * @brief Draw from @p budget with @p weight (nullptr detaches
+             * and returns what this writer holds). Falls back to no budget
+             * if @p budget has no free account.
+             */
+            void setTxBudget(TxBudget *budget, uint8_t weight);
+
             /**
              * @brief Check if send buffer has space for writing
              * @return true if send buffer has space, false otherwise
@@ -154,8 +192,33 @@ namespace async_tcp {
 
             void onAckCallback(tcp_pcb *pcb, uint16_t len);
 
+            /// Bytes handed to tcp_write() since construction.
+            [[nodiscard]] std::size_t queuedBytes() const { return m_queued; }
+
+            /// Bytes the peer has ACKed since construction.
+            [[nodiscard]] std::size_t ackedBytes() const { return m_acked; }
+
             void setOnAckCallback(const AckCallback &cb) { m_ack_cb = cb; }
 
+            /**
+             * @brief Called at the end of every writeData() with its result,
+             * 0 when rejected; the send buffer has changed either way.
+             */
+            void setOnWrittenCallback(const WrittenCallback &cb) {
+                m_written_cb = cb;
+            }
+
+            /**
+             * @brief Attach (or detach with nullptr) TX stage timing.
+             */
+            void setStageTimings(StageTimings *timings) { m_timings = timings; }
+
+            /**
+             * @brief Attach (or detach with nullptr) adaptive Nagle control;
+             * each writeData() then sets the PCB's Nagle flag from it.
+             */
+            void setAdaptiveNagle(AdaptiveNagle *nagle) { m_nagle = nagle; }
+
             void onError(err_t error);
     };
 
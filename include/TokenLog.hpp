@@ -0,0 +1,164 @@
+/**
+ * @file TokenLog.hpp
+ * @brief Tokenized logging backend for DEBUGWIRE/DEBUGCORE.
+ *
+ * When ASYNC_TCP_TOKENIZED_LOG is defined, every DEBUGWIRE()/DEBUGCORE()
+ * statement compiled after this header is reduced to a 32-bit token (the
+ * FNV-1a hash of its format string) plus its raw arguments. The format string
+ * never reaches flash and nothing is formatted on the device: a log call is a
+ * single append of 3 + argc words to the ring of the calling core.
+ *
+ * The rings are drained with TokenLog::dump() and decoded on the host by
+ * tools/detokenize.py, which rebuilds the token dictionary from the sources.
+ *
+ * Record layout (little-endian 32-bit words):
+ *  - header: 0xA5 << 24 | argc << 16 | core << 12 | sequence (12 bits)
+ *  - token
+ *  - time_us_32() at the log call
+ *  - argc argument words (integers, pointers, floats as IEEE-754 single)
+ *
+ * Only 32-bit values fit a word: "%s" (the string would dangle by dump
+ * time) and 64-bit conversions ("%ll..", "%j..") are rejected at compile
+ * time, as are char pointers and wider integer arguments.
+ *
+ * Without ASYNC_TCP_TOKENIZED_LOG the core macros are left untouched.
+ * Include this header from source files only: it redefines the core log
+ * macros for everything compiled after it.
+ */
+
+#pragma once
+
+#include "hash_util.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "debug_internal.h"
+
+#ifndef ASYNC_TCP_TLOG_RING_WORDS
+#define ASYNC_TCP_TLOG_RING_WORDS 512 // per core; must be a power of two
+#endif
+
+class Print;
+
+namespace async_tcp {
+
+    class TokenLog {
+
+            static_assert((ASYNC_TCP_TLOG_RING_WORDS &
+                           (ASYNC_TCP_TLOG_RING_WORDS - 1)) == 0,
+                          "ASYNC_TCP_TLOG_RING_WORDS must be a power of two");
+
+            template <typename T>
+            static std::uint32_t toWord(const T value) {
+                static_assert(
+                    !std::is_same_v<std::remove_cv_t<
+                                        std::remove_pointer_t<T>>, char>,
+                    "Strings cannot be tokenized; log a length or id");
+                if constexpr (std::is_pointer_v<T>) {
+                    return static_cast<std::uint32_t>(
+                        reinterpret_cast<std::uintptr_t>(value));
+                } else if constexpr (std::is_floating_point_v<T>) {
+                    const auto f = static_cast<float>(value);
+                    std::uint32_t w;
+                    std::memcpy(&w, &f, sizeof(w));
+                    return w;
+                } else {
+                    static_assert(sizeof(T) <= sizeof(std::uint32_t),
+                                  "64-bit arguments would be truncated");
+                    return static_cast<std::uint32_t>(value);
+                }
+            }
+
+            static void append(std::uint32_t token, const std::uint32_t *args,
+                               std::size_t argc);
+
+            static constexpr bool oneOf(const char *set, const char c) {
+                while (*set) {
+                    if (*set++ == c) {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+        public:
+            static constexpr std::uint32_t MAGIC = 0xA5;
+            static constexpr std::size_t MAX_ARGS = 15;
+
+            /**
+             * @brief Whether every conversion in @p fmt fits one word (no
+             * "%s", no "ll"/"j" length).
+             */
+            static constexpr bool formatSupported(const char *fmt) {
+                while (*fmt) {
+                    if (*fmt++ != '%') {
+                        continue;
+                    }
+                    if (*fmt == '%') {
+                        ++fmt;
+                        continue;
+                    }
+                    while (*fmt && oneOf("-+ #0123456789.", *fmt)) {
+                        ++fmt;
+                    }
+                    if (*fmt == 'j' || (fmt[0] == 'l' && fmt[1] == 'l')) {
+                        return false;
+                    }
+                    while (*fmt && oneOf("hlzt", *fmt)) {
+                        ++fmt;
+                    }
+                    if (*fmt == 's') {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            /**
+             * @brief Append one tokenized record to the calling core's ring.
+             *
+             * Safe from both cores and from IRQ context. When the ring lacks
+             * room the record is dropped whole and counted, so the stream
+             * stays parseable.
+             */
+            template <typename... Args>
+            static void write(const std::uint32_t token, const Args... args) {
+                static_assert(sizeof...(Args) <= MAX_ARGS,
+                              "Too many arguments for a tokenized record");
+                const std::uint32_t words[] = {toWord(args)..., 0};
+                append(token, words, sizeof...(Args));
+            }
+
+            /**
+             * @brief Move all buffered records of both cores to @p out.
+             *
+             * There must be a single reader at a time; writers keep running.
+             * @return Number of bytes written.
+             */
+            static std::size_t dump(Print &out);
+
+            /**
+             * @brief Records dropped because a ring was full (both cores).
+             */
+            static std::uint32_t dropped();
+    };
+
+} // namespace async_tcp
+
+#define ASYNC_TCP_TLOG(fmt, ...)                                               \
+    do {                                                                       \
+        static_assert(::async_tcp::TokenLog::formatSupported(fmt),            \
+                      "Tokenized logs take 32-bit arguments only");          \
+        constexpr std::uint32_t async_tcp_token_ = ::async_tcp::fnv1a(fmt);   \
+        ::async_tcp::TokenLog::write(async_tcp_token_, ##__VA_ARGS__);        \
+    } while (0)
+
+#ifdef ASYNC_TCP_TOKENIZED_LOG
+#undef DEBUGWIRE
+#define DEBUGWIRE(...) ASYNC_TCP_TLOG(__VA_ARGS__)
+#undef DEBUGCORE
+#define DEBUGCORE(...) ASYNC_TCP_TLOG(__VA_ARGS__)
+#endif
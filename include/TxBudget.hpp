@@ -0,0 +1,93 @@
+/**
+ * @file TxBudget.hpp
+ * @brief Global TX byte budget shared fairly across TcpWriters.
+ *
+ * Every connection queues into the same lwIP segment and pbuf pools, so a
+ * single bulk uploader can fill MEMP_NUM_TCP_SEG and leave interactive
+ * writers with ERR_MEM. TxBudget caps the bytes all attached writers may
+ * have queued but not yet ACKed at total(). Each account is guaranteed
+ * minimum() bytes and gets a share of the rest weighted by its priority:
+ *
+ *     share_i = minimum + (total - n * minimum) * weight_i / sum(weights)
+ *
+ * A writer at or above its share sees no room until ACKs release bytes, and
+ * other accounts' unused guarantees are never handed out, so a small
+ * interactive write always finds room.
+ *
+ * Charged on queue (TcpWriter::writeData, TcpClientContext::writeChunk) and
+ * released on ACK. All calls run on the networking core with the lwIP lock
+ * held, so the budget needs no locking of its own.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <lwip/opt.h>
+
+#ifndef ASYNC_TCP_TX_BUDGET_ACCOUNTS
+#define ASYNC_TCP_TX_BUDGET_ACCOUNTS 16
+#endif
+
+namespace async_tcp {
+
+    class TxBudget {
+        public:
+            struct Account {
+                    std::size_t in_flight = 0; ///< Charged, not yet released
+                    std::size_t peak = 0;
+                    uint32_t throttled = 0; ///< Writes refused for lack of budget
+                    uint8_t weight = 0;     ///< 0 = slot free
+            };
+
+            /**
+             * @param total Bytes all accounts may have in flight together;
+             * defaults to what the segment pool can hold at full MSS.
+             * @param minimum Bytes guaranteed to every open account.
+             */
+            explicit TxBudget(std::size_t total = MEMP_NUM_TCP_SEG * TCP_MSS,
+                              std::size_t minimum = TCP_MSS);
+
+            TxBudget(const TxBudget &) = delete;
+            TxBudget &operator=(const TxBudget &) = delete;
+
+            /**
+             * @brief Open an account with @p weight (>= 1; e.g. 4 for
+             * interactive, 1 for bulk).
+             * @return nullptr if all slots are taken.
+             */
+            Account *open(uint8_t weight);
+
+            /**
+             * @brief Release everything @p account still holds and free it.
+             */
+            void close(Account *account);
+
+            /**
+             * @brief Bytes @p account may queue now.
+             */
+            [[nodiscard]] std::size_t allowance(const Account &account) const;
+
+            void charge(Account &account, std::size_t bytes);
+
+            /**
+             * @brief Return ACKed bytes (clamped to what was charged).
+             */
+            void release(Account &account, std::size_t bytes);
+
+            [[nodiscard]] std::size_t share(const Account &account) const;
+
+            [[nodiscard]] std::size_t total() const { return m_total; }
+            [[nodiscard]] std::size_t minimum() const { return m_minimum; }
+            [[nodiscard]] std::size_t used() const { return m_used; }
+
+        private:
+            Account m_accounts[ASYNC_TCP_TX_BUDGET_ACCOUNTS]{};
+            std::size_t m_total;
+            std::size_t m_minimum;
+            std::size_t m_used = 0;
+            uint32_t m_weights = 0;
+            uint8_t m_open = 0;
+    };
+
+} // namespace async_tcp
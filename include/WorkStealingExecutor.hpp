@@ -0,0 +1,164 @@
+/**
+ * @file WorkStealingExecutor.hpp
+ * @brief Two-core executor with per-core deques and work stealing.
+ *
+ * Application handler work (parsing, formatting, compression) does not
+ * need the networking core. A bridge that is core-agnostic does the lwIP
+ * part in its onWork() and submits the rest with Affinity::Any; the task
+ * lands on the submitting core's deque and either core may run it. Each
+ * core calls runOnce()/run() from its own loop (loop() and loop1() in
+ * Arduino-Pico): it takes its pinned tasks first, then the newest task of
+ * its own deque, and when idle steals the oldest task from the other core.
+ *
+ * Anything touching lwIP must use Affinity::Networking, which pins the
+ * task to the core given to the constructor and is never stolen. Such
+ * tasks run under the lock of the context given to setNetworkingContext(),
+ * so they cannot race lwIP's background work.
+ *
+ * Each deque is guarded by one RP2040 hardware spin lock, held only for
+ * the few instructions of a push, pop or steal. Tasks are a function
+ * pointer plus argument, so submitting never allocates.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <cstddef>
+#include <cstdint>
+#include <hardware/sync.h>
+#include <pico/async_context.h>
+
+#ifndef ASYNC_TCP_EXEC_DEQUE_SIZE
+#define ASYNC_TCP_EXEC_DEQUE_SIZE 32 // tasks per deque, power of two
+#endif
+
+namespace async_tcp {
+
+    class WorkStealingExecutor {
+        public:
+            using TaskFn = void (*)(void *arg);
+
+            enum class Affinity : uint8_t {
+                Any,        ///< Either core; may be stolen
+                Networking, ///< Pinned to the networking core
+                Core0,      ///< Pinned to core 0
+                Core1       ///< Pinned to core 1
+            };
+
+            struct Stats {
+                    uint32_t executed = 0; ///< Tasks run on this core
+                    uint32_t stolen = 0;   ///< ...of which taken from the other
+                    uint32_t busy_us = 0;  ///< Time spent inside tasks
+                    uint32_t window_us = 0; ///< Time since resetStats()
+                    uint32_t rejected = 0; ///< Submits refused, deque full
+
+                    [[nodiscard]] float utilization() const {
+                        return window_us ? static_cast<float>(busy_us) /
+                                               static_cast<float>(window_us)
+                                         : 0.0f;
+                    }
+            };
+
+            static constexpr std::size_t DEQUE_SIZE = ASYNC_TCP_EXEC_DEQUE_SIZE;
+            static_assert((DEQUE_SIZE & (DEQUE_SIZE - 1)) == 0,
+                          "ASYNC_TCP_EXEC_DEQUE_SIZE must be a power of two");
+
+            /**
+             * @param networking_core Core that owns the lwIP async context.
+             */
+            explicit WorkStealingExecutor(uint8_t networking_core = 0);
+
+            ~WorkStealingExecutor();
+
+            WorkStealingExecutor(const WorkStealingExecutor &) = delete;
+            WorkStealingExecutor &
+            operator=(const WorkStealingExecutor &) = delete;
+
+            /**
+             * @brief Context whose lock Affinity::Networking tasks run
+             * under (the lwIP async context). Call before submitting them.
+             */
+            void setNetworkingContext(async_context_t *ctx) {
+                m_networking_ctx = ctx;
+            }
+
+            /**
+             * @brief Queue @p fn(@p arg). Callable from either core, not
+             * from an ISR.
+             * @return false if the target deque is full, or for
+             * Affinity::Networking without a networking context; run it
+             * inline then.
+             */
+            bool submit(TaskFn fn, void *arg, Affinity affinity = Affinity::Any);
+
+            /**
+             * @brief Submit a callable object by pointer; it must outlive the
+             * task.
+             */
+            template <typename F>
+            bool submit(F *callable, const Affinity affinity = Affinity::Any) {
+                return submit([](void *p) { (*static_cast<F *>(p))(); },
+                              callable, affinity);
+            }
+
+            /**
+             * @brief Run at most one task on the calling core.
+             * @return false when there was nothing to run or steal.
+             */
+            bool runOnce();
+
+            /**
+             * @brief Run tasks until none are left or @p budget_us passes.
+             * @return Number of tasks run.
+             */
+            std::size_t run(uint32_t budget_us);
+
+            [[nodiscard]] Stats stats(uint8_t core) const;
+
+            /**
+             * @brief Restart the utilization window of both cores. Call at
+             * least every ~70 minutes; busy time is a 32-bit counter.
+             */
+            void resetStats();
+
+            /**
+             * @brief One line per core: tasks, steals, utilization.
+             */
+            void print(Print &out) const;
+
+        private:
+            struct Task {
+                    TaskFn fn;
+                    void *arg;
+            };
+
+            /// Bounded deque: owner uses the bottom, thieves the top.
+            struct Deque {
+                    Task tasks[DEQUE_SIZE]{};
+                    uint32_t top = 0;    ///< Oldest task
+                    uint32_t bottom = 0; ///< One past the newest task
+                    spin_lock_t *lock = nullptr;
+            };
+
+            struct PerCore {
+                    Deque stealable;
+                    Deque pinned;
+                    Stats stats;
+                    uint32_t window_start_us = 0;
+            };
+
+            static bool push(Deque &d, Task task);
+            static bool popBottom(Deque &d, Task &task);
+            static bool popTop(Deque &d, Task &task);
+
+            static void release(Deque &d);
+
+            void execute(PerCore &self, Task task, bool stolen);
+
+            PerCore m_cores[NUM_CORES];
+            Deque m_networking; ///< Affinity::Networking, under the ctx lock
+            uint8_t m_networking_core;
+            async_context_t *m_networking_ctx = nullptr;
+    };
+
+} // namespace async_tcp
@@ -0,0 +1,40 @@
+// hash_util.hpp
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace async_tcp {
+
+    inline constexpr std::uint32_t FNV1A_OFFSET_BASIS = 2166136261u;
+    inline constexpr std::uint32_t FNV1A_PRIME = 16777619u;
+
+    /**
+     * @brief 32-bit FNV-1a hash of a NUL-terminated string.
+     *
+     * constexpr so that log format strings can be hashed at compile time;
+     * tools/detokenize.py implements the same function on the host.
+     */
+    constexpr std::uint32_t fnv1a(const char *s,
+                                  std::uint32_t h = FNV1A_OFFSET_BASIS) {
+        while (*s) {
+            h ^= static_cast<std::uint8_t>(*s++);
+            h *= FNV1A_PRIME;
+        }
+        return h;
+    }
+
+    /**
+     * @brief 32-bit FNV-1a hash of a byte range, chainable via @p h.
+     */
+    inline std::uint32_t fnv1a(const void *data, const std::size_t len,
+                               std::uint32_t h = FNV1A_OFFSET_BASIS) {
+        const auto *p = static_cast<const std::uint8_t *>(data);
+        for (std::size_t i = 0; i < len; ++i) {
+            h ^= p[i];
+            h *= FNV1A_PRIME;
+        }
+        return h;
+    }
+
+} // namespace async_tcp
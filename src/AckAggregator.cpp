@@ -0,0 +1,166 @@
+/**
+ * @file AckAggregator.cpp
+ * @brief Pending-client list and flush workers for AckAggregator.
+ */
+
+#include "AckAggregator.hpp"
+
+#include "TcpClient.hpp"
+#include <pico/time.h>
+
+namespace async_tcp {
+
+    AckAggregator::AckAggregator(async_context_t *ctx, const Config &config)
+        : m_ctx(ctx), m_config(config) {
+        if (m_config.flush_bytes > UINT16_MAX) {
+            m_config.flush_bytes = UINT16_MAX;
+        }
+        m_timer.do_work = &AckAggregator::s_flush_at;
+        m_timer.user_data = this;
+        m_cycle.do_work = &AckAggregator::s_flush_pending;
+        m_cycle.user_data = this;
+        async_context_add_when_pending_worker(m_ctx, &m_cycle);
+    }
+
+    AckAggregator::~AckAggregator() {
+        async_context_acquire_lock_blocking(m_ctx);
+        if (m_armed) {
+            async_context_remove_at_time_worker(m_ctx, &m_timer);
+        }
+        async_context_remove_when_pending_worker(m_ctx, &m_cycle);
+        for (uint8_t i = 0; i < m_count; ++i) {
+            m_dirty[i]->m_ack_dirty = false;
+        }
+        async_context_release_lock(m_ctx);
+    }
+
+    void AckAggregator::add(TcpClient &client, const uint16_t len) {
+        ++m_stats.acks;
+        m_stats.bytes += len;
+
+        // Keep every notification within the uint16_t bridge payload.
+        if (client.m_ack_pending.load(std::memory_order_relaxed) + len >
+            UINT16_MAX) {
+            deliver(client);
+        }
+        const uint32_t pending =
+            client.m_ack_pending.fetch_add(len, std::memory_order_relaxed) +
+            len;
+
+        if (pending >= m_config.flush_bytes) {
+            deliver(client);
+            return;
+        }
+        if (client.m_ack_dirty) {
+            return;
+        }
+        if (m_count == ASYNC_TCP_ACK_CLIENTS) {
+            ++m_stats.overflows;
+            deliver(client);
+            return;
+        }
+        client.m_ack_dirty = true;
+        m_dirty[m_count++] = &client;
+        arm();
+    }
+
+    void AckAggregator::flush() {
+        // deliver() may run application handlers, which can add() new
+        // clients or cancel() listed ones; deliver from a copy of the list.
+        TcpClient *batch[ASYNC_TCP_ACK_CLIENTS];
+        const uint8_t count = m_count;
+        for (uint8_t i = 0; i < count; ++i) {
+            batch[i] = m_dirty[i];
+        }
+        m_count = 0;
+        m_flushing = batch;
+        m_flush_count = count;
+        for (uint8_t i = 0; i < count; ++i) {
+            if (TcpClient *client = batch[i]) {
+                client->m_ack_dirty = false;
+                deliver(*client);
+            }
+        }
+        m_flushing = nullptr;
+        m_flush_count = 0;
+    }
+
+    void AckAggregator::cancel(TcpClient &client) {
+        async_context_acquire_lock_blocking(m_ctx);
+        uint8_t kept = 0;
+        for (uint8_t i = 0; i < m_count; ++i) {
+            if (m_dirty[i] != &client) {
+                m_dirty[kept++] = m_dirty[i];
+            }
+        }
+        m_count = kept;
+        for (uint8_t i = 0; i < m_flush_count; ++i) {
+            if (m_flushing[i] == &client) {
+                m_flushing[i] = nullptr; // destroyed by a handler mid-flush
+            }
+        }
+        client.m_ack_dirty = false;
+        async_context_release_lock(m_ctx);
+    }
+
+    void AckAggregator::deliver(TcpClient &client) {
+        const uint32_t bytes =
+            client.m_ack_pending.exchange(0, std::memory_order_relaxed);
+        if (bytes) {
+            ++m_stats.notifications;
+            client._dispatchAck(static_cast<uint16_t>(bytes));
+        }
+    }
+
+    void AckAggregator::arm() {
+        if (m_config.max_delay_us == 0) {
+            async_context_set_work_pending(m_ctx, &m_cycle);
+        } else if (!m_armed) {
+            // One timer for the batch: nothing waits longer than
+            // max_delay_us, later ACKs ride along with the first.
+            async_context_add_at_time_worker_at(
+                m_ctx, &m_timer, make_timeout_time_us(m_config.max_delay_us));
+            m_armed = true;
+        }
+    }
+
+    void AckAggregator::s_flush_at(async_context_t *ctx,
+                                   async_at_time_worker_t *worker) {
+        (void)ctx;
+        auto *self = static_cast<AckAggregator *>(worker->user_data);
+        self->m_armed = false; // at-time workers are one-shot
+        self->flush();
+    }
+
+    void AckAggregator::s_flush_pending(async_context_t *ctx,
+                                        async_when_pending_worker_t *worker) {
+        (void)ctx;
+        static_cast<AckAggregator *>(worker->user_data)->flush();
+    }
+
+    AckAggregator::Stats AckAggregator::stats() const {
+        async_context_acquire_lock_blocking(m_ctx);
+        const Stats s = m_stats;
+        async_context_release_lock(m_ctx);
+        return s;
+    }
+
+    void AckAggregator::resetStats() {
+        async_context_acquire_lock_blocking(m_ctx);
+        m_stats = {};
+        async_context_release_lock(m_ctx);
+    }
+
+    void AckAggregator::print(Print &out) const {
+        const Stats s = stats();
+        const unsigned long per_notification =
+            s.notifications ? s.acks / s.notifications : 0;
+        out.printf("[ack] acks=%lu notifications=%lu (%lu per) overflows=%lu "
+                   "bytes=%llu\n",
+                   static_cast<unsigned long>(s.acks),
+                   static_cast<unsigned long>(s.notifications),
+                   per_notification,
+                   static_cast<unsigned long>(s.overflows), s.bytes);
+    }
+
+} // namespace async_tcp
@@ -0,0 +1,80 @@
+/**
+ * @file AdaptiveNagle.cpp
+ * @brief EWMA classification and hysteresis for AdaptiveNagle.
+ */
+
+#include "AdaptiveNagle.hpp"
+
+namespace async_tcp {
+
+    namespace {
+
+        // avg += (sample - avg) / 2^shift, on a value scaled by 2^shift.
+        uint32_t ewma(const uint32_t scaled, const uint32_t sample,
+                      const uint8_t shift) {
+            return scaled - (scaled >> shift) + sample;
+        }
+
+    } // namespace
+
+    bool AdaptiveNagle::observe(const std::size_t bytes, const uint32_t t_us) {
+        const auto size =
+            static_cast<uint32_t>(bytes > UINT16_MAX ? UINT16_MAX : bytes);
+        if (!m_seen) {
+            // Seed with the first write; the first gap counts as idle.
+            m_avg_bytes = size << SHIFT;
+            m_avg_gap = m_config.bulk_gap_us << SHIFT;
+            m_seen = true;
+        } else {
+            const uint32_t gap = t_us - m_last_us;
+            m_avg_bytes = ewma(m_avg_bytes, size, SHIFT);
+            m_avg_gap = ewma(m_avg_gap, gap > 1000000 ? 1000000 : gap, SHIFT);
+        }
+        m_last_us = t_us;
+
+        const bool bulk = averageBytes() >= m_config.bulk_bytes &&
+                          averageGapUs() < m_config.bulk_gap_us;
+        if (bulk == m_coalesce) {
+            m_streak = 0;
+            return m_coalesce;
+        }
+        const uint8_t needed =
+            bulk ? m_config.enter_bulk : m_config.exit_bulk;
+        if (++m_streak < needed) {
+            return m_coalesce;
+        }
+
+        m_streak = 0;
+        m_coalesce = bulk;
+        m_history[m_switches % ASYNC_TCP_NAGLE_HISTORY] = {
+            t_us, averageBytes(), averageGapUs(), m_coalesce};
+        ++m_switches;
+        return m_coalesce;
+    }
+
+    bool AdaptiveNagle::history(const std::size_t i, Decision &out) const {
+        if (i >= m_switches || i >= ASYNC_TCP_NAGLE_HISTORY) {
+            return false;
+        }
+        out = m_history[(m_switches - 1 - i) % ASYNC_TCP_NAGLE_HISTORY];
+        return true;
+    }
+
+    void AdaptiveNagle::print(Print &out) const {
+        out.printf("[nagle] mode=%s avg_bytes=%lu avg_gap_us=%lu "
+                   "switches=%lu\n",
+                   m_coalesce ? "coalesce" : "nodelay",
+                   static_cast<unsigned long>(averageBytes()),
+                   static_cast<unsigned long>(averageGapUs()),
+                   static_cast<unsigned long>(m_switches));
+        Decision d{};
+        for (std::size_t i = 0; history(i, d); ++i) {
+            out.printf("[nagle]  t=%lu %s bytes=%lu gap_us=%lu\n",
+                       static_cast<unsigned long>(d.t_us),
+                       d.coalesce ? "coalesce" : "nodelay",
+                       static_cast<unsigned long>(d.avg_bytes),
+                       static_cast<unsigned long>(d.avg_gap_us));
+        }
+    }
+
+} // namespace async_tcp
@@ -0,0 +1,107 @@
+/**
+ * @file BytePipe.cpp
+ * @brief Producer and consumer sides of BytePipe.
+ */
+
+#include "BytePipe.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <hardware/sync.h>
+#include <pico/time.h>
+
+namespace async_tcp {
+
+    BytePipe::BytePipe(uint8_t *storage, const std::size_t capacity)
+        : m_buf(storage), m_capacity(capacity) {
+        assert(capacity && (capacity & (capacity - 1)) == 0 &&
+               "BytePipe capacity must be a power of two");
+    }
+
+    BytePipe::Spans BytePipe::spans(const uint32_t pos,
+                                    const std::size_t n) const {
+        const std::size_t offset = pos & (m_capacity - 1);
+        const std::size_t first = std::min(n, m_capacity - offset);
+        return {{m_buf + offset, first}, {m_buf, n - first}};
+    }
+
+    BytePipe::Spans BytePipe::reserve(const std::size_t max) const {
+        const uint32_t head = m_head.load(std::memory_order_relaxed);
+        const uint32_t tail = m_tail.load(std::memory_order_acquire);
+        return spans(head, std::min(m_capacity - (head - tail), max));
+    }
+
+    void BytePipe::commit(const std::size_t n) {
+        if (n == 0) {
+            return;
+        }
+        const uint32_t head = m_head.load(std::memory_order_relaxed);
+        m_head.store(head + static_cast<uint32_t>(n),
+                     std::memory_order_release);
+        if (m_read_worker) {
+            async_context_set_work_pending(m_read_ctx, m_read_worker);
+        }
+        __sev();
+    }
+
+    std::size_t BytePipe::write(const uint8_t *data, const std::size_t size) {
+        const Spans s = reserve(size);
+        std::memcpy(s.first.data, data, s.first.size);
+        std::memcpy(s.second.data, data + s.first.size, s.second.size);
+        commit(s.size());
+        return s.size();
+    }
+
+    BytePipe::Spans BytePipe::peek(const std::size_t max) const {
+        const uint32_t tail = m_tail.load(std::memory_order_relaxed);
+        const uint32_t head = m_head.load(std::memory_order_acquire);
+        return spans(tail, std::min<std::size_t>(head - tail, max));
+    }
+
+    void BytePipe::release(const std::size_t n) {
+        if (n == 0) {
+            return;
+        }
+        const uint32_t tail = m_tail.load(std::memory_order_relaxed);
+        m_tail.store(tail + static_cast<uint32_t>(n),
+                     std::memory_order_release);
+        if (m_write_worker) {
+            async_context_set_work_pending(m_write_ctx, m_write_worker);
+        }
+        __sev();
+    }
+
+    std::size_t BytePipe::read(uint8_t *out, const std::size_t size) {
+        const Spans s = peek(size);
+        std::memcpy(out, s.first.data, s.first.size);
+        std::memcpy(out + s.first.size, s.second.data, s.second.size);
+        release(s.size());
+        return s.size();
+    }
+
+    bool BytePipe::waitReadable(const std::size_t min,
+                                const uint32_t timeout_us) const {
+        const absolute_time_t deadline = make_timeout_time_us(timeout_us);
+        while (readable() < min) {
+            if (time_reached(deadline)) {
+                return false;
+            }
+            best_effort_wfe_or_timeout(deadline);
+        }
+        return true;
+    }
+
+    bool BytePipe::waitWritable(const std::size_t min,
+                                const uint32_t timeout_us) const {
+        const absolute_time_t deadline = make_timeout_time_us(timeout_us);
+        while (writable() < min) {
+            if (time_reached(deadline)) {
+                return false;
+            }
+            best_effort_wfe_or_timeout(deadline);
+        }
+        return true;
+    }
+
+} // namespace async_tcp
@@ -0,0 +1,56 @@
+/**
+ * @file CompletionQueue.cpp
+ * @brief Producer and consumer sides of CompletionQueue.
+ */
+
+#include "CompletionQueue.hpp"
+
+#include <hardware/sync.h>
+#include <pico/time.h>
+
+namespace async_tcp {
+
+    bool CompletionQueue::post(const Completion::Type type,
+                               const uint8_t client_id, const int32_t value,
+                               const ClientHandle handle) {
+        const uint32_t head = m_head.load(std::memory_order_relaxed);
+        const uint32_t tail = m_tail.load(std::memory_order_acquire);
+        if (head - tail == CAPACITY) {
+            m_overflows.store(m_overflows.load(std::memory_order_relaxed) + 1,
+                              std::memory_order_relaxed);
+            return false;
+        }
+        m_ring[head & (CAPACITY - 1)] = {time_us_32(), value, type, client_id,
+                                         0, handle};
+        m_head.store(head + 1, std::memory_order_release);
+        __sev();
+        return true;
+    }
+
+    std::size_t CompletionQueue::drain(Completion *out, const std::size_t max) {
+        const uint32_t tail = m_tail.load(std::memory_order_relaxed);
+        const uint32_t head = m_head.load(std::memory_order_acquire);
+        std::size_t n = head - tail;
+        if (n > max) {
+            n = max;
+        }
+        for (std::size_t i = 0; i < n; ++i) {
+            out[i] = m_ring[(tail + i) & (CAPACITY - 1)];
+        }
+        m_tail.store(tail + static_cast<uint32_t>(n),
+                     std::memory_order_release);
+        return n;
+    }
+
+    bool CompletionQueue::waitNonEmpty(const uint32_t timeout_us) const {
+        const absolute_time_t deadline = make_timeout_time_us(timeout_us);
+        while (empty()) {
+            if (time_reached(deadline)) {
+                return false;
+            }
+            best_effort_wfe_or_timeout(deadline);
+        }
+        return true;
+    }
+
+} // namespace async_tcp
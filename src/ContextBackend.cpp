@@ -0,0 +1,83 @@
+/**
+ * @file ContextBackend.cpp
+ * @brief Initialisation and servicing of the selectable context backends.
+ */
+
+#include "ContextBackend.hpp"
+
+#include <pico/time.h>
+
+namespace async_tcp {
+
+    const char *ContextBackend::name(const Kind kind) {
+        switch (kind) {
+        case Kind::ThreadsafeBackground:
+            return "threadsafe_background";
+        case Kind::Poll:
+            return "poll";
+        case Kind::FreeRtos:
+            return "freertos";
+        }
+        return "?";
+    }
+
+    bool ContextBackend::init(const Kind kind, const uint8_t core) {
+        (void)core;
+        deinit();
+        m_kind = kind;
+        switch (kind) {
+        case Kind::ThreadsafeBackground: {
+            auto config = async_context_threadsafe_background_default_config();
+            m_ready = async_context_threadsafe_background_init(
+                &m_storage.background, &config);
+            m_context = &m_storage.background.core;
+            break;
+        }
+        case Kind::Poll:
+            m_ready = async_context_poll_init_with_defaults(&m_storage.poll);
+            m_context = &m_storage.poll.core;
+            break;
+        case Kind::FreeRtos: {
+#if ASYNC_TCP_HAS_FREERTOS_CONTEXT
+            auto config = async_context_freertos_default_config();
+#if configUSE_CORE_AFFINITY && configNUMBER_OF_CORES > 1
+            config.task_core_id = core;
+#endif
+            m_ready = async_context_freertos_init(&m_storage.freertos, &config);
+            m_context = &m_storage.freertos.core;
+#endif
+            break;
+        }
+        }
+        if (!m_ready) {
+            m_context = nullptr;
+        }
+        return m_ready;
+    }
+
+    void ContextBackend::deinit() {
+        if (m_ready) {
+            async_context_deinit(m_context);
+            m_ready = false;
+            m_context = nullptr;
+        }
+    }
+
+    void ContextBackend::poll() {
+        if (m_ready && m_kind == Kind::Poll) {
+            async_context_poll(m_context);
+        }
+    }
+
+    void ContextBackend::run(const absolute_time_t until) {
+        if (!m_ready || m_kind != Kind::Poll) {
+            sleep_until(until);
+            return;
+        }
+        while (!time_reached(until)) {
+            async_context_poll(m_context);
+            async_context_wait_for_work_until(m_context, until);
+        }
+    }
+
+} // namespace async_tcp
@@ -0,0 +1,130 @@
+/**
+ * @file EpochReclaimer.cpp
+ * @brief Epoch announcement and collection for EpochReclaimer.
+ */
+
+#include "EpochReclaimer.hpp"
+
+#include <cassert>
+
+namespace async_tcp {
+
+    EpochReclaimer::EpochReclaimer()
+        : m_lock(spin_lock_instance(spin_lock_claim_unused(true))) {
+        m_worker.do_work = &EpochReclaimer::s_do_work;
+        m_worker.user_data = this;
+    }
+
+    EpochReclaimer::~EpochReclaimer() { setContext(nullptr); }
+
+    void EpochReclaimer::setContext(async_context_t *ctx) {
+        if (m_armed) {
+            async_context_remove_at_time_worker(m_ctx, &m_worker);
+            m_armed = false;
+        }
+        m_ctx = ctx;
+        arm();
+    }
+
+    // Under the context lock: from retire(), setContext() or the worker.
+    void EpochReclaimer::arm() {
+        if (m_ctx && !m_armed && pending()) {
+            async_context_add_at_time_worker_in_ms(m_ctx, &m_worker,
+                                                   ASYNC_TCP_EPOCH_COLLECT_MS);
+            m_armed = true;
+        }
+    }
+
+    void EpochReclaimer::s_do_work(async_context_t *ctx,
+                                   async_at_time_worker_t *worker) {
+        (void)ctx;
+        auto *self = static_cast<EpochReclaimer *>(worker->user_data);
+        self->m_armed = false; // at-time workers are one-shot
+        self->collect();
+        self->arm();
+    }
+
+    void EpochReclaimer::enter() {
+        const uint8_t core = get_core_num();
+        if (m_depth[core]++ == 0) {
+            // seq_cst: the announcement must be visible before the guarded
+            // pointer loads that follow.
+            m_active[core].store(m_epoch.load(std::memory_order_seq_cst),
+                                 std::memory_order_seq_cst);
+        }
+    }
+
+    void EpochReclaimer::exit() {
+        const uint8_t core = get_core_num();
+        if (--m_depth[core] == 0) {
+            m_active[core].store(0, std::memory_order_release);
+        }
+    }
+
+    bool EpochReclaimer::reclaimable(const uint32_t epoch) const {
+        for (const auto &active : m_active) {
+            const uint32_t e = active.load(std::memory_order_seq_cst);
+            // A reader that entered at or before the retire epoch may have
+            // loaded the pointer before it was unpublished.
+            if (e && static_cast<int32_t>(e - epoch) <= 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void EpochReclaimer::retire(void *ptr, const Deleter deleter) {
+        assert(!m_depth[get_core_num()] && "retire() inside a Guard");
+        if (!ptr) {
+            return;
+        }
+        for (;;) {
+            uint32_t save = spin_lock_blocking(m_lock);
+            if (m_count < ASYNC_TCP_EPOCH_RETIRED) {
+                // Stamp and advance in one step: readers announcing the new
+                // epoch started after the pointer was unpublished.
+                const uint32_t epoch =
+                    m_epoch.fetch_add(1, std::memory_order_seq_cst);
+                m_retired[m_count++] = {ptr, deleter, epoch};
+                ++m_stats.retired;
+                if (m_count > m_stats.max_pending) {
+                    m_stats.max_pending = m_count;
+                }
+                spin_unlock(m_lock, save);
+                break;
+            }
+            ++m_stats.stalls;
+            spin_unlock(m_lock, save);
+            if (!collect()) {
+                tight_loop_contents();
+            }
+        }
+        collect();
+        arm(); // what the other core still guards is freed later
+    }
+
+    std::size_t EpochReclaimer::collect() {
+        Retired ready[ASYNC_TCP_EPOCH_RETIRED];
+        std::size_t n = 0;
+
+        const uint32_t save = spin_lock_blocking(m_lock);
+        std::size_t kept = 0;
+        for (std::size_t i = 0; i < m_count; ++i) {
+            if (reclaimable(m_retired[i].epoch)) {
+                ready[n++] = m_retired[i];
+            } else {
+                m_retired[kept++] = m_retired[i];
+            }
+        }
+        m_count = kept;
+        m_stats.freed += n;
+        spin_unlock(m_lock, save);
+
+        // Deleters may be slow (pbuf release, heap): run them unlocked.
+        for (std::size_t i = 0; i < n; ++i) {
+            ready[i].deleter(ready[i].ptr);
+        }
+        return n;
+    }
+
+} // namespace async_tcp
@@ -0,0 +1,119 @@
+/**
+ * @file EventRecorder.cpp
+ * @brief Fixed-capacity trace storage and serialisation for EventRecorder.
+ */
+
+#include "EventRecorder.hpp"
+
+#include "hash_util.hpp"
+#include <pico/time.h>
+
+namespace async_tcp {
+
+    namespace {
+
+        EventRecord s_records[ASYNC_TCP_EVENT_RECORDER_CAPACITY];
+        std::size_t s_count = 0;
+        uint32_t s_dropped = 0;
+        bool s_active = false;
+        bool s_hash_payloads = true;
+
+        std::size_t put16(Print &out, const uint16_t v) {
+            const uint8_t b[2] = {static_cast<uint8_t>(v),
+                                  static_cast<uint8_t>(v >> 8)};
+            return out.write(b, sizeof(b));
+        }
+
+        std::size_t put32(Print &out, const uint32_t v) {
+            const uint8_t b[4] = {
+                static_cast<uint8_t>(v), static_cast<uint8_t>(v >> 8),
+                static_cast<uint8_t>(v >> 16), static_cast<uint8_t>(v >> 24)};
+            return out.write(b, sizeof(b));
+        }
+
+    } // namespace
+
+    void EventRecorder::start(const bool hash_payloads) {
+        s_count = 0;
+        s_dropped = 0;
+        s_hash_payloads = hash_payloads;
+        s_active = true;
+    }
+
+    void EventRecorder::stop() { s_active = false; }
+
+    bool EventRecorder::active() { return s_active; }
+
+    void EventRecorder::record(const EventType type, const uint8_t client_id,
+                               const uint16_t len, const uint32_t hash) {
+        if (!s_active) {
+            return;
+        }
+        if (s_count == ASYNC_TCP_EVENT_RECORDER_CAPACITY) {
+            ++s_dropped;
+            return;
+        }
+        s_records[s_count++] = {time_us_32(), hash, len, type, client_id};
+    }
+
+    void EventRecorder::recordError(const EventType type,
+                                    const uint8_t client_id, const err_t err) {
+        record(type, client_id,
+               static_cast<uint16_t>(static_cast<int16_t>(err)));
+    }
+
+    void EventRecorder::recordRecv(const uint8_t client_id, const pbuf *p) {
+        if (!s_active || !p) {
+            return;
+        }
+        std::size_t segments = 0;
+        uint32_t hash = FNV1A_OFFSET_BASIS;
+        for (auto *q = p; q; q = q->next) {
+            ++segments;
+            if (s_hash_payloads) {
+                hash = fnv1a(q->payload, q->len, hash);
+            }
+        }
+        const std::size_t need = segments > 1 ? segments + 1 : 1;
+        if (ASYNC_TCP_EVENT_RECORDER_CAPACITY - s_count < need) {
+            ++s_dropped;
+            return;
+        }
+        record(EventType::Recv, client_id, p->tot_len,
+               s_hash_payloads ? hash : 0);
+        if (segments > 1) {
+            for (auto *q = p; q; q = q->next) {
+                record(EventType::Segment, client_id, q->len);
+            }
+        }
+    }
+
+    std::size_t EventRecorder::size() { return s_count; }
+
+    uint32_t EventRecorder::dropped() { return s_dropped; }
+
+    const EventRecord *EventRecorder::records() { return s_records; }
+
+    std::size_t EventRecorder::dump(Print &out) {
+        std::size_t written = out.write(
+            reinterpret_cast<const uint8_t *>("ATEV"), 4);
+        const uint8_t version[2] = {FORMAT_VERSION,
+                                    static_cast<uint8_t>(sizeof(EventRecord))};
+        written += out.write(version, sizeof(version));
+        written += put16(out, 0);
+        written += put32(out, static_cast<uint32_t>(s_count));
+        written += put32(out, s_dropped);
+
+        for (std::size_t i = 0; i < s_count; ++i) {
+            const auto &r = s_records[i];
+            written += put32(out, r.t_us);
+            written += put32(out, r.hash);
+            written += put16(out, r.len);
+            const uint8_t tail[2] = {static_cast<uint8_t>(r.type),
+                                     r.client_id};
+            written += out.write(tail, sizeof(tail));
+        }
+        return written;
+    }
+
+} // namespace async_tcp
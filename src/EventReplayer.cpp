@@ -0,0 +1,189 @@
+/**
+ * @file EventReplayer.cpp
+ * @brief Replay of recorded lwIP event sequences.
+ */
+
+#include "EventReplayer.hpp"
+
+#include "TcpClientContext.hpp"
+#include <cstring>
+#include <pico/time.h>
+
+namespace async_tcp {
+
+    namespace {
+
+        constexpr std::size_t RECORD_SIZE = sizeof(EventRecord);
+
+        uint16_t get16(const uint8_t *p) {
+            return static_cast<uint16_t>(p[0] | p[1] << 8);
+        }
+
+        uint32_t get32(const uint8_t *p) {
+            return static_cast<uint32_t>(p[0]) |
+                   static_cast<uint32_t>(p[1]) << 8 |
+                   static_cast<uint32_t>(p[2]) << 16 |
+                   static_cast<uint32_t>(p[3]) << 24;
+        }
+
+        /**
+         * @brief Fill a payload with a xorshift32 stream seeded by the hash.
+         */
+        void fill(pbuf *p, const uint32_t seed) {
+            uint32_t x = seed ? seed : 0x9E3779B9u;
+            for (auto *q = p; q; q = q->next) {
+                auto *bytes = static_cast<uint8_t *>(q->payload);
+                for (u16_t i = 0; i < q->len; ++i) {
+                    x ^= x << 13;
+                    x ^= x >> 17;
+                    x ^= x << 5;
+                    bytes[i] = static_cast<uint8_t>(x);
+                }
+            }
+        }
+
+    } // namespace
+
+    EventReplayer::EventReplayer(TcpClientContext &ctx, const int client_id)
+        : m_ctx(ctx), m_client_filter(client_id) {}
+
+    bool EventReplayer::load(const uint8_t *trace, const std::size_t size) {
+        m_records = nullptr;
+        m_count = 0;
+        rewind();
+
+        if (!trace || size < EventRecorder::HEADER_SIZE ||
+            std::memcmp(trace, "ATEV", 4) != 0 ||
+            trace[4] != EventRecorder::FORMAT_VERSION ||
+            trace[5] != RECORD_SIZE) {
+            return false;
+        }
+
+        const std::size_t count = get32(trace + 8);
+        if (size < EventRecorder::HEADER_SIZE + count * RECORD_SIZE) {
+            return false;
+        }
+        m_records = trace + EventRecorder::HEADER_SIZE;
+        m_count = count;
+        return true;
+    }
+
+    void EventReplayer::rewind() {
+        m_next = 0;
+        m_stats = {};
+    }
+
+    EventRecord EventReplayer::decode(const std::size_t index) const {
+        const uint8_t *p = m_records + index * RECORD_SIZE;
+        return {get32(p), get32(p + 4), get16(p + 8),
+                static_cast<EventType>(p[10]), p[11]};
+    }
+
+    bool EventReplayer::step() {
+        if (m_next >= m_count) {
+            return false;
+        }
+        const auto record = decode(m_next++);
+        if (m_client_filter >= 0 && record.client_id != m_client_filter) {
+            m_next += record.type == EventType::Recv ? segmentsAt(m_next) : 0;
+            ++m_stats.skipped;
+            return true;
+        }
+        deliver(record);
+        return true;
+    }
+
+    std::size_t EventReplayer::segmentsAt(const std::size_t index) const {
+        std::size_t n = 0;
+        while (index + n < m_count &&
+               decode(index + n).type == EventType::Segment) {
+            ++n;
+        }
+        return n;
+    }
+
+    void EventReplayer::deliverRecv(const EventRecord &record) {
+        // Rebuild the recorded chain; no Segment records means one pbuf.
+        const std::size_t segments = segmentsAt(m_next);
+        pbuf *chain = nullptr;
+        bool failed = false;
+        for (std::size_t i = 0; i < (segments ? segments : 1); ++i) {
+            const u16_t len =
+                segments ? decode(m_next + i).len : record.len;
+            pbuf *p = pbuf_alloc(PBUF_RAW, len, PBUF_RAM);
+            if (!p) {
+                failed = true;
+                break;
+            }
+            if (chain) {
+                pbuf_cat(chain, p);
+            } else {
+                chain = p;
+            }
+        }
+        m_next += segments;
+        if (failed) {
+            if (chain) {
+                pbuf_free(chain);
+            }
+            ++m_stats.skipped;
+            return;
+        }
+        fill(chain, record.hash);
+        lwip_receive_callback(&m_ctx, m_ctx._pcb, chain, ERR_OK);
+        m_stats.rx_bytes += record.len;
+        ++m_stats.events;
+    }
+
+    const EventReplayer::Stats &EventReplayer::replay(const bool paced) {
+        const uint32_t start = time_us_32();
+        const uint32_t origin = m_next < m_count ? decode(m_next).t_us : 0;
+
+        while (m_next < m_count) {
+            if (paced) {
+                const uint32_t due = start + (decode(m_next).t_us - origin);
+                while (static_cast<int32_t>(due - time_us_32()) > 0) {
+                    tight_loop_contents();
+                }
+            }
+            step();
+        }
+
+        m_stats.elapsed_us = time_us_32() - start;
+        return m_stats;
+    }
+
+    void EventReplayer::deliver(const EventRecord &record) {
+        tcp_pcb *pcb = m_ctx._pcb;
+        const auto err = static_cast<err_t>(static_cast<int16_t>(record.len));
+
+        switch (record.type) {
+        case EventType::Recv:
+            deliverRecv(record);
+            return;
+        case EventType::Fin:
+            lwip_receive_callback(&m_ctx, pcb, nullptr, ERR_OK);
+            break;
+        case EventType::Sent:
+            // The recorded connection had a writer; the replay one is lazy.
+            (void)m_ctx.getTxWriter();
+            lwip_sent_cb(&m_ctx, pcb, record.len);
+            m_stats.acked_bytes += record.len;
+            break;
+        case EventType::Poll:
+            TcpClientContext::_s_poll(&m_ctx, pcb);
+            break;
+        case EventType::Error:
+            TcpClientContext::_s_error(&m_ctx, err);
+            break;
+        case EventType::Connected:
+            TcpClientContext::_s_connected(&m_ctx, pcb, err);
+            break;
+        default:
+            ++m_stats.skipped;
+            return;
+        }
+        ++m_stats.events;
+    }
+
+} // namespace async_tcp
@@ -0,0 +1,48 @@
+/**
+ * @file HandleTable.cpp
+ * @brief Slot allocation and generation bumps for HandleTable.
+ */
+
+#include "HandleTable.hpp"
+
+namespace async_tcp {
+
+    ClientHandle HandleTable::next(const uint8_t index) {
+        Slot &s = m_slots[index];
+        // 24-bit generation; skip 0 so a handle is never INVALID.
+        s.generation = (s.generation + 1) & ((1u << (32 - INDEX_BITS)) - 1);
+        if (!s.generation) {
+            s.generation = 1;
+        }
+        const ClientHandle handle = s.generation << INDEX_BITS | index;
+        s.handle.store(handle, std::memory_order_release);
+        return handle;
+    }
+
+    ClientHandle HandleTable::attach(TcpClient &client) {
+        for (uint8_t i = 0; i < ASYNC_TCP_HANDLE_SLOTS; ++i) {
+            if (!m_slots[i].client) {
+                m_slots[i].client = &client;
+                return next(i);
+            }
+        }
+        return INVALID;
+    }
+
+    ClientHandle HandleTable::renew(const ClientHandle handle) {
+        if (!isCurrent(handle)) {
+            return INVALID;
+        }
+        return next(indexOf(handle));
+    }
+
+    void HandleTable::release(const ClientHandle handle) {
+        if (!isCurrent(handle)) {
+            return;
+        }
+        Slot &s = m_slots[indexOf(handle)];
+        s.handle.store(INVALID, std::memory_order_release);
+        s.client = nullptr;
+    }
+
+} // namespace async_tcp
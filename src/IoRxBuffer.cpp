@@ -3,7 +3,9 @@
 //
 #include "IoRxBuffer.hpp"
 
+#include "StageTimings.hpp"
 #include "TcpClientContext.hpp"
+#include "TokenLog.hpp"
 #include <algorithm>
 #include <cassert>
 
@@ -28,10 +30,10 @@ namespace async_tcp {
         // In embedded systems, these should never be null during normal
         // operation If they are, it's a fundamental initialization failure.
         assert(arg);
-        const auto *ctx = static_cast<TcpClientContext *>(arg);
+        auto *ctx = static_cast<TcpClientContext *>(arg);
 
-        const auto rx_buffer = ctx->getRxBuffer();
-        assert(rx_buffer);
+        // The buffer is created on the first receive event (data or FIN).
+        const auto rx_buffer = ctx->initRxBuffer();
 
         // ReSharper disable once CppDFAUnreachableCode
         rx_buffer->_pcb = tpcb;
@@ -51,11 +53,15 @@ namespace async_tcp {
                       tpcb->state);
 
             // FIN received — connection is closing
+            ASYNC_TCP_RECORD(Fin, ctx->getClientId(), 0);
             rx_buffer->_onFinCallback();
 
             return ERR_ABRT;
         }
 
+        ASYNC_TCP_RECORD_RECV(ctx->getClientId(), p);
+        rx_buffer->_received_total += p->tot_len;
+
         // Normal case: append new data or take ownership of first pbuf
         if (rx_buffer->_head) {
             DEBUGWIRE("[:i%d] :rxclb cat h%p p=%p\n", ctx->getClientId(),
@@ -70,6 +76,10 @@ namespace async_tcp {
             rx_buffer->_offset = 0;
         }
 
+        if (rx_buffer->_timings) {
+            rx_buffer->_timings->rxArrival();
+        }
+
         // Notify application that new data is available
         rx_buffer->_onReceivedCallback();
 
@@ -202,6 +212,9 @@ namespace async_tcp {
         if (!_head) {
             return 0;
         }
+        if (_timings) {
+            _timings->rxHandlerStart();
+        }
         return _head->len - _offset;
     }
 
@@ -209,6 +222,9 @@ namespace async_tcp {
         if (!_head) {
             return nullptr;
         }
+        if (_timings) {
+            _timings->rxHandlerStart();
+        }
         return static_cast<const char *>(_head->payload) + _offset;
     }
 
@@ -224,6 +240,7 @@ namespace async_tcp {
             return;
         }
 
+        const uint32_t t_consume = _timings ? time_us_32() : 0;
         const std::size_t available = _head->len - _offset;
         const std::size_t remaining = n;         // bytes still to consume
         std::size_t consumed = 0;          // total bytes actually removed
@@ -240,6 +257,14 @@ namespace async_tcp {
         if (_pcb && consumed > 0) {
             _toAck(consumed);
         }
+
+        if (_timings) {
+            _timings->rxConsumed(t_consume, _head == nullptr);
+        }
+
+        if (!_head && _drainedCb) {
+            _drainedCb();
+        }
     }
 
     void IoRxBuffer::setOnFinCallback(const fin_callback_t &cb) {
@@ -249,4 +274,8 @@ namespace async_tcp {
     void IoRxBuffer::setOnReceivedCallback(const received_callback_t &cb) {
         _receivedCb = cb;
     }
+
+    void IoRxBuffer::setOnDrainedCallback(const drained_callback_t &cb) {
+        _drainedCb = cb;
+    }
 } // namespace async_tcp
@@ -0,0 +1,201 @@
+/**
+ * @file LatencyHistogram.cpp
+ * @brief Bucket mapping, snapshots and varint serialization.
+ */
+
+#include "LatencyHistogram.hpp"
+
+namespace async_tcp {
+
+    namespace {
+
+        std::size_t putVarint(uint8_t *out, std::size_t pos,
+                              const std::size_t cap, uint64_t v) {
+            do {
+                if (pos >= cap) {
+                    return 0;
+                }
+                auto byte = static_cast<uint8_t>(v & 0x7F);
+                v >>= 7;
+                if (v) {
+                    byte |= 0x80;
+                }
+                out[pos++] = byte;
+            } while (v);
+            return pos;
+        }
+
+        bool getVarint(const uint8_t *in, std::size_t &pos,
+                       const std::size_t len, uint64_t &v) {
+            v = 0;
+            for (uint8_t shift = 0; shift < 64; shift += 7) {
+                if (pos >= len) {
+                    return false;
+                }
+                const uint8_t byte = in[pos++];
+                v |= static_cast<uint64_t>(byte & 0x7F) << shift;
+                if (!(byte & 0x80)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+    } // namespace
+
+    std::size_t LatencyHistogram::bucketOf(const uint32_t us) {
+        if (us < SUB_COUNT) {
+            return us;
+        }
+        const auto exponent = static_cast<uint8_t>(31 - __builtin_clz(us));
+        if (exponent > MAX_EXPONENT) {
+            return BUCKETS - 1;
+        }
+        const uint32_t sub = (us >> (exponent - SUB_BITS)) & (SUB_COUNT - 1);
+        return SUB_COUNT + (exponent - SUB_BITS) * SUB_COUNT + sub;
+    }
+
+    uint32_t LatencyHistogram::lowerBound(const std::size_t bucket) {
+        if (bucket < SUB_COUNT) {
+            return static_cast<uint32_t>(bucket);
+        }
+        const auto octave = static_cast<uint8_t>((bucket - SUB_COUNT) /
+                                                 SUB_COUNT);
+        const auto sub = static_cast<uint32_t>((bucket - SUB_COUNT) %
+                                               SUB_COUNT);
+        return (SUB_COUNT + sub) << octave;
+    }
+
+    uint32_t LatencyHistogram::upperBound(const std::size_t bucket) {
+        if (bucket < SUB_COUNT) {
+            return static_cast<uint32_t>(bucket);
+        }
+        if (bucket >= BUCKETS - 1) {
+            return UINT32_MAX;
+        }
+        return lowerBound(bucket + 1) - 1;
+    }
+
+    uint32_t LatencyHistogram::Snapshot::percentile(const float pct) const {
+        if (!count) {
+            return 0;
+        }
+        auto rank = static_cast<uint64_t>(static_cast<double>(count) *
+                                          static_cast<double>(pct) / 100.0 +
+                                          0.5);
+        if (rank < 1) {
+            rank = 1;
+        }
+        uint64_t seen = 0;
+        for (std::size_t b = 0; b < BUCKETS; ++b) {
+            seen += buckets[b];
+            if (seen >= rank) {
+                const uint32_t upper = upperBound(b);
+                return upper < max_us ? upper : max_us;
+            }
+        }
+        return max_us;
+    }
+
+    void LatencyHistogram::Snapshot::merge(const Snapshot &other) {
+        for (std::size_t b = 0; b < BUCKETS; ++b) {
+            buckets[b] += other.buckets[b];
+        }
+        count += other.count;
+        sum_us += other.sum_us;
+        if (other.max_us > max_us) {
+            max_us = other.max_us;
+        }
+    }
+
+    std::size_t LatencyHistogram::Snapshot::serialize(uint8_t *out,
+                                                      const std::size_t cap)
+        const {
+        std::size_t used = 0;
+        for (const auto c : buckets) {
+            used += c ? 1 : 0;
+        }
+        if (!out || cap == 0) {
+            return 0;
+        }
+        out[0] = FORMAT_VERSION;
+        std::size_t pos = 1;
+        pos = putVarint(out, pos, cap, used);
+        pos = pos ? putVarint(out, pos, cap, max_us) : 0;
+        pos = pos ? putVarint(out, pos, cap, sum_us) : 0;
+
+        std::size_t last = 0;
+        for (std::size_t b = 0; b < BUCKETS && pos; ++b) {
+            if (!buckets[b]) {
+                continue;
+            }
+            pos = putVarint(out, pos, cap, b - last);
+            pos = pos ? putVarint(out, pos, cap, buckets[b]) : 0;
+            last = b;
+        }
+        return pos;
+    }
+
+    bool LatencyHistogram::Snapshot::deserialize(const uint8_t *in,
+                                                 const std::size_t len) {
+        if (!in || len == 0 || in[0] != FORMAT_VERSION) {
+            return false;
+        }
+        Snapshot s;
+        std::size_t pos = 1;
+        uint64_t used = 0;
+        uint64_t max = 0;
+        if (!getVarint(in, pos, len, used) || used > BUCKETS ||
+            !getVarint(in, pos, len, max) ||
+            !getVarint(in, pos, len, s.sum_us)) {
+            return false;
+        }
+        s.max_us = static_cast<uint32_t>(max);
+
+        uint64_t bucket = 0;
+        for (uint64_t i = 0; i < used; ++i) {
+            uint64_t gap = 0;
+            uint64_t c = 0;
+            if (!getVarint(in, pos, len, gap) ||
+                !getVarint(in, pos, len, c)) {
+                return false;
+            }
+            bucket += gap;
+            if (bucket >= BUCKETS || (i && !gap)) {
+                return false;
+            }
+            s.buckets[bucket] = static_cast<uint32_t>(c);
+            s.count += static_cast<uint32_t>(c);
+        }
+        *this = s;
+        return true;
+    }
+
+    void LatencyHistogram::merge(const Snapshot &other) {
+        begin();
+        m_data.merge(other);
+        end();
+    }
+
+    void LatencyHistogram::reset() {
+        begin();
+        m_data = {};
+        end();
+    }
+
+    LatencyHistogram::Snapshot LatencyHistogram::snapshot() const {
+        Snapshot copy;
+        uint32_t before = 0;
+        do {
+            before = m_seq.load(std::memory_order_acquire);
+            if (before & 1U) {
+                continue; // a write is in progress
+            }
+            copy = m_data;
+            std::atomic_thread_fence(std::memory_order_acquire);
+        } while (before & 1U ||
+                 m_seq.load(std::memory_order_relaxed) != before);
+        return copy;
+    }
+
+} // namespace async_tcp
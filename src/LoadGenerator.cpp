@@ -0,0 +1,274 @@
+/**
+ * @file LoadGenerator.cpp
+ * @brief Connection state machines and reporting for LoadGenerator.
+ */
+
+#include "LoadGenerator.hpp"
+
+#include "TcpClientContext.hpp"
+#include <algorithm>
+#include <pico/time.h>
+
+namespace async_tcp {
+
+    namespace {
+
+        uint8_t s_payload[TCP_MSS];
+
+        void fillPayload() {
+            for (std::size_t i = 0; i < sizeof(s_payload); ++i) {
+                s_payload[i] = static_cast<uint8_t>('A' + i % 26);
+            }
+        }
+
+    } // namespace
+
+    LoadGenerator::LoadGenerator(const Config &config) : m_config(config) {
+        m_config.connections = std::min<uint16_t>(m_config.connections,
+                                                  ASYNC_TCP_LOAD_MAX_CONNS);
+        for (uint16_t i = 0; i < ASYNC_TCP_LOAD_MAX_CONNS; ++i) {
+            m_conns[i].owner = this;
+            m_conns[i].id = static_cast<uint8_t>(i);
+        }
+        fillPayload();
+    }
+
+    LoadGenerator::~LoadGenerator() { stop(); }
+
+    void LoadGenerator::start() {
+        m_counters = {};
+        m_latency.reset();
+        m_started_us = time_us_64();
+        m_ended_us = 0;
+        m_running = true;
+        for (uint16_t i = 0; i < m_config.connections; ++i) {
+            m_conns[i].next_us = m_started_us;
+        }
+    }
+
+    void LoadGenerator::stop() {
+        const uint64_t now = time_us_64();
+        for (auto &c : m_conns) {
+            if (c.ctx) {
+                close(c, now);
+            }
+        }
+        if (m_running) {
+            m_running = false;
+            m_ended_us = now;
+        }
+    }
+
+    bool LoadGenerator::poll() {
+        if (!m_running) {
+            return false;
+        }
+        const uint64_t now = time_us_64();
+        if (now - m_started_us >=
+            static_cast<uint64_t>(m_config.duration_ms) * 1000) {
+            stop();
+            return false;
+        }
+        for (uint16_t i = 0; i < m_config.connections; ++i) {
+            pump(m_conns[i], now);
+        }
+        return true;
+    }
+
+    void LoadGenerator::open(Conn &c, const uint64_t now) {
+        tcp_pcb *pcb = tcp_new();
+        if (!pcb) {
+            ++m_counters.connect_failures;
+            c.next_us = now + 1000;
+            return;
+        }
+
+        c.ctx = new TcpClientContext(pcb);
+        c.ctx->setClientId(c.id);
+        c.connected = false;
+        c.fin = false;
+        c.failed = false;
+        c.received = 0;
+        c.to_send = 0;
+        c.requests = 0;
+        c.t_start_us = now;
+        c.state = State::Connecting;
+
+        c.ctx->setOnConnectCallback([&c] { c.connected = true; });
+        c.ctx->setOnReceivedCallback([this, &c] { onReceive(c); });
+        c.ctx->setOnFinCallback([&c] { c.fin = true; });
+        c.ctx->setOnErrorCallback([&c](err_t) { c.failed = true; });
+
+        IPAddress addr = m_config.server;
+        if (c.ctx->connect(addr, m_config.port) != ERR_OK) {
+            delete c.ctx;
+            c.ctx = nullptr;
+            c.state = State::Idle;
+            c.next_us = now + 1000;
+            ++m_counters.connect_failures;
+        }
+    }
+
+    void LoadGenerator::close(Conn &c, const uint64_t now) {
+        // After tcp_err the PCB is already freed by lwIP.
+        if (!c.failed) {
+            c.ctx->close();
+        }
+        delete c.ctx;
+        c.ctx = nullptr;
+        c.state = State::Idle;
+        c.next_us = now + static_cast<uint64_t>(m_config.think_time_ms) * 1000;
+    }
+
+    void LoadGenerator::onReceive(Conn &c) {
+        auto *rx = c.ctx->getRxBuffer();
+        while (const auto n = rx->peekAvailable()) {
+            c.received += n;
+            m_counters.bytes_rx += n;
+            rx->peekConsume(n);
+        }
+    }
+
+    void LoadGenerator::send(Conn &c) {
+        auto *tx = c.ctx->getTxWriter();
+        while (c.to_send) {
+            const auto chunk = std::min(
+                {c.to_send, sizeof(s_payload), tx->getOptimalChunkSize(c.to_send)});
+            if (chunk == 0) {
+                return;
+            }
+            const auto queued = tx->writeData(s_payload, chunk);
+            if (queued == 0) {
+                return;
+            }
+            c.to_send -= queued;
+            m_counters.bytes_tx += queued;
+        }
+    }
+
+    void LoadGenerator::pump(Conn &c, const uint64_t now) {
+        if (c.state == State::Idle) {
+            if (now >= c.next_us) {
+                open(c, now);
+            }
+            return;
+        }
+
+        if (c.failed) {
+            if (c.state == State::Connecting) {
+                ++m_counters.connect_failures;
+            } else {
+                ++m_counters.errors;
+            }
+            close(c, now);
+            return;
+        }
+
+        if (c.state == State::Connecting) {
+            if (!c.connected) {
+                return;
+            }
+            ++m_counters.connections;
+            c.state = State::Active;
+            c.next_us = now;
+        }
+
+        if (c.fin) {
+            if (m_config.mode == Mode::Qotd) {
+                sample(now - c.t_start_us);
+                ++m_counters.requests;
+            }
+            close(c, now);
+            return;
+        }
+
+        const bool limit_reached = m_config.requests_per_connection &&
+                                   c.requests >= m_config.requests_per_connection;
+
+        switch (m_config.mode) {
+        case Mode::Echo:
+            if (c.to_send == 0 && c.received >= m_config.message_size &&
+                c.t_start_us) {
+                // Response complete.
+                sample(now - c.t_start_us);
+                ++m_counters.requests;
+                ++c.requests;
+                c.received -= m_config.message_size;
+                c.t_start_us = 0;
+                c.next_us =
+                    now + static_cast<uint64_t>(m_config.think_time_ms) * 1000;
+                if (m_config.requests_per_connection &&
+                    c.requests >= m_config.requests_per_connection) {
+                    close(c, now);
+                    return;
+                }
+            }
+            if (!c.t_start_us && now >= c.next_us) {
+                c.t_start_us = now;
+                c.to_send = m_config.message_size;
+            }
+            send(c);
+            break;
+        case Mode::Discard:
+            if (limit_reached && c.to_send == 0) {
+                close(c, now);
+                return;
+            }
+            if (c.to_send == 0 && now >= c.next_us) {
+                c.to_send = m_config.message_size;
+                ++c.requests;
+                ++m_counters.requests;
+                c.next_us =
+                    now + static_cast<uint64_t>(m_config.think_time_ms) * 1000;
+            }
+            send(c);
+            break;
+        case Mode::Chargen:
+        case Mode::Qotd:
+            break;
+        }
+    }
+
+    void LoadGenerator::sample(const uint64_t latency_us) {
+        m_latency.record(static_cast<uint32_t>(
+            std::min<uint64_t>(latency_us, UINT32_MAX)));
+    }
+
+    LoadGenerator::Report LoadGenerator::report() const {
+        Report r = m_counters;
+        const uint64_t end = m_running ? time_us_64() : m_ended_us;
+        const uint64_t elapsed_us = end - m_started_us;
+        r.elapsed_ms = static_cast<uint32_t>(elapsed_us / 1000);
+        if (elapsed_us) {
+            const auto seconds = static_cast<float>(elapsed_us) / 1e6f;
+            r.connections_per_s = static_cast<float>(r.connections) / seconds;
+            r.mb_per_s =
+                static_cast<float>(r.bytes_tx + r.bytes_rx) / 1e6f / seconds;
+        }
+
+        const auto latency = m_latency.snapshot();
+        r.latency_p50_us = latency.percentile(50);
+        r.latency_p90_us = latency.percentile(90);
+        r.latency_p99_us = latency.percentile(99);
+        r.latency_max_us = latency.max_us;
+        return r;
+    }
+
+    void LoadGenerator::print(const Report &r, Print &out) {
+        out.printf("[load] %lums conns=%lu (%.1f/s) fail=%lu err=%lu "
+                   "req=%lu tx=%llu rx=%llu %.3fMB/s\n",
+                   static_cast<unsigned long>(r.elapsed_ms),
+                   static_cast<unsigned long>(r.connections),
+                   static_cast<double>(r.connections_per_s),
+                   static_cast<unsigned long>(r.connect_failures),
+                   static_cast<unsigned long>(r.errors),
+                   static_cast<unsigned long>(r.requests), r.bytes_tx,
+                   r.bytes_rx, static_cast<double>(r.mb_per_s));
+        out.printf("[load] latency us p50=%lu p90=%lu p99=%lu max=%lu\n",
+                   static_cast<unsigned long>(r.latency_p50_us),
+                   static_cast<unsigned long>(r.latency_p90_us),
+                   static_cast<unsigned long>(r.latency_p99_us),
+                   static_cast<unsigned long>(r.latency_max_us));
+    }
+
+} // namespace async_tcp
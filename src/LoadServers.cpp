@@ -0,0 +1,267 @@
+/**
+ * @file LoadServers.cpp
+ * @brief lwIP raw-API QOTD, echo, discard and chargen servers.
+ */
+
+#include "LoadServers.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace async_tcp {
+
+    namespace {
+
+        constexpr std::size_t CHARGEN_LINE = 72;   // RFC 864 line width
+        constexpr std::size_t CHARGEN_CHARS = 95;  // printable ASCII ' '..'~'
+
+    } // namespace
+
+    bool LoadServers::begin(const Service service, const uint16_t port) {
+        auto &l = m_listeners[static_cast<uint8_t>(service)];
+        if (l.pcb) {
+            return false;
+        }
+
+        tcp_pcb *pcb = tcp_new_ip_type(IPADDR_TYPE_ANY);
+        if (!pcb) {
+            return false;
+        }
+        if (tcp_bind(pcb, IP_ANY_TYPE, port) != ERR_OK) {
+            tcp_close(pcb);
+            return false;
+        }
+        tcp_pcb *listen = tcp_listen(pcb);
+        if (!listen) {
+            tcp_close(pcb);
+            return false;
+        }
+
+        l = {this, listen, service};
+        tcp_arg(listen, &l);
+        tcp_accept(listen, &LoadServers::s_accept);
+        return true;
+    }
+
+    bool LoadServers::beginAll(const uint16_t port_offset) {
+        return begin(Service::Qotd, QOTD_PORT + port_offset) &&
+               begin(Service::Echo, ECHO_PORT + port_offset) &&
+               begin(Service::Discard, DISCARD_PORT + port_offset) &&
+               begin(Service::Chargen, CHARGEN_PORT + port_offset);
+    }
+
+    void LoadServers::end() {
+        for (auto &c : m_conns) {
+            if (c.pcb) {
+                release(c, true);
+            }
+        }
+        for (auto &l : m_listeners) {
+            if (l.pcb) {
+                tcp_arg(l.pcb, nullptr);
+                tcp_accept(l.pcb, nullptr);
+                tcp_close(l.pcb);
+                l.pcb = nullptr;
+            }
+        }
+    }
+
+    LoadServers::Conn *LoadServers::slot() {
+        for (auto &c : m_conns) {
+            if (!c.pcb) {
+                return &c;
+            }
+        }
+        return nullptr;
+    }
+
+    err_t LoadServers::s_accept(void *arg, tcp_pcb *pcb, const err_t err) {
+        if (err != ERR_OK || !pcb || !arg) {
+            return ERR_VAL;
+        }
+        const auto *l = static_cast<Listener *>(arg);
+        return l->owner->accept(l->service, pcb);
+    }
+
+    err_t LoadServers::accept(const Service service, tcp_pcb *pcb) {
+        auto &stats = m_stats[static_cast<uint8_t>(service)];
+        Conn *c = slot();
+        if (!c) {
+            ++stats.rejected;
+            tcp_abort(pcb);
+            return ERR_ABRT;
+        }
+        ++stats.accepted;
+
+        *c = Conn{};
+        c->owner = this;
+        c->pcb = pcb;
+        c->service = service;
+        tcp_arg(pcb, c);
+        tcp_recv(pcb, &LoadServers::s_recv);
+        tcp_sent(pcb, &LoadServers::s_sent);
+        tcp_err(pcb, &LoadServers::s_error);
+        tcp_nagle_disable(pcb);
+
+        switch (service) {
+        case Service::Qotd: {
+            const auto len = static_cast<u16_t>(std::strlen(m_quote));
+            tcp_write(pcb, m_quote, len, 0); // quote is static, no copy
+            stats.bytes_out += len;
+            return release(*c, false); // FIN goes out after the quote
+        }
+        case Service::Chargen:
+            chargenFill(*c);
+            break;
+        default:
+            break;
+        }
+        return ERR_OK;
+    }
+
+    err_t LoadServers::s_recv(void *arg, tcp_pcb *pcb, pbuf *p,
+                              const err_t err) {
+        (void)pcb;
+        auto *c = static_cast<Conn *>(arg);
+        if (!c) {
+            if (p) {
+                pbuf_free(p);
+            }
+            return ERR_OK;
+        }
+        LoadServers &self = *c->owner;
+
+        if (err != ERR_OK || !p) {
+            if (p) {
+                pbuf_free(p);
+            }
+            return self.release(*c, false);
+        }
+
+        self.m_stats[static_cast<uint8_t>(c->service)].bytes_in += p->tot_len;
+
+        if (c->service == Service::Echo) {
+            if (c->pending) {
+                pbuf_cat(c->pending, p);
+            } else {
+                c->pending = p;
+                c->pending_offset = 0;
+            }
+            self.echoFlush(*c);
+            return ERR_OK;
+        }
+
+        // Discard, chargen and qotd ignore input.
+        tcp_recved(c->pcb, p->tot_len);
+        pbuf_free(p);
+        return ERR_OK;
+    }
+
+    err_t LoadServers::s_sent(void *arg, tcp_pcb *pcb, const u16_t len) {
+        (void)pcb;
+        (void)len;
+        auto *c = static_cast<Conn *>(arg);
+        if (!c) {
+            return ERR_OK;
+        }
+        if (c->service == Service::Echo) {
+            c->owner->echoFlush(*c);
+        } else if (c->service == Service::Chargen) {
+            c->owner->chargenFill(*c);
+        }
+        return ERR_OK;
+    }
+
+    void LoadServers::s_error(void *arg, const err_t err) {
+        (void)err;
+        auto *c = static_cast<Conn *>(arg);
+        if (!c) {
+            return;
+        }
+        // The PCB is already gone; only drop our state.
+        c->pcb = nullptr;
+        if (c->pending) {
+            pbuf_free(c->pending);
+            c->pending = nullptr;
+        }
+    }
+
+    void LoadServers::echoFlush(Conn &c) {
+        std::size_t queued = 0;
+        while (c.pending) {
+            const auto sndbuf = static_cast<std::size_t>(tcp_sndbuf(c.pcb));
+            const std::size_t avail = c.pending->len - c.pending_offset;
+            const auto n = static_cast<u16_t>(std::min(sndbuf, avail));
+            if (n == 0) {
+                break;
+            }
+            const auto *src =
+                static_cast<const uint8_t *>(c.pending->payload) +
+                c.pending_offset;
+            if (tcp_write(c.pcb, src, n, TCP_WRITE_FLAG_COPY) != ERR_OK) {
+                break;
+            }
+            queued += n;
+            c.pending_offset += n;
+            if (c.pending_offset == c.pending->len) {
+                pbuf *done = c.pending;
+                c.pending = done->next;
+                c.pending_offset = 0;
+                if (c.pending) {
+                    pbuf_ref(c.pending);
+                }
+                pbuf_free(done);
+            }
+        }
+        if (queued) {
+            tcp_output(c.pcb);
+            tcp_recved(c.pcb, static_cast<u16_t>(queued));
+            m_stats[static_cast<uint8_t>(Service::Echo)].bytes_out += queued;
+        }
+    }
+
+    void LoadServers::chargenFill(Conn &c) {
+        char line[CHARGEN_LINE + 2];
+        std::size_t queued = 0;
+        while (tcp_sndbuf(c.pcb) >= sizeof(line)) {
+            for (std::size_t i = 0; i < CHARGEN_LINE; ++i) {
+                line[i] = static_cast<char>(
+                    ' ' + (c.chargen_pos + i) % CHARGEN_CHARS);
+            }
+            line[CHARGEN_LINE] = '\r';
+            line[CHARGEN_LINE + 1] = '\n';
+            if (tcp_write(c.pcb, line, sizeof(line), TCP_WRITE_FLAG_COPY) !=
+                ERR_OK) {
+                break;
+            }
+            c.chargen_pos = (c.chargen_pos + 1) % CHARGEN_CHARS;
+            queued += sizeof(line);
+        }
+        if (queued) {
+            tcp_output(c.pcb);
+            m_stats[static_cast<uint8_t>(Service::Chargen)].bytes_out +=
+                queued;
+        }
+    }
+
+    err_t LoadServers::release(Conn &c, const bool abort) {
+        err_t res = ERR_OK;
+        if (c.pending) {
+            pbuf_free(c.pending);
+            c.pending = nullptr;
+        }
+        if (c.pcb) {
+            tcp_arg(c.pcb, nullptr);
+            tcp_recv(c.pcb, nullptr);
+            tcp_sent(c.pcb, nullptr);
+            tcp_err(c.pcb, nullptr);
+            if (abort || tcp_close(c.pcb) != ERR_OK) {
+                tcp_abort(c.pcb);
+                res = ERR_ABRT; // callers inside lwIP callbacks return this
+            }
+            c.pcb = nullptr;
+        }
+        return res;
+    }
+
+} // namespace async_tcp
@@ -0,0 +1,192 @@
+/**
+ * @file MagazineAllocator.cpp
+ * @brief Arenas, per-core magazines and the shared depot.
+ */
+
+#include "MagazineAllocator.hpp"
+
+#include <hardware/sync.h>
+#include <new>
+
+namespace async_tcp {
+
+    namespace {
+
+        constexpr std::size_t CLASSES = MagazineAllocator::CLASSES;
+        constexpr std::size_t BLOCKS = ASYNC_TCP_MAG_BLOCKS;
+        constexpr std::size_t ROUNDS = ASYNC_TCP_MAG_ROUNDS;
+        constexpr std::size_t BATCH = ROUNDS / 2; // blocks per depot exchange
+
+        static_assert(ROUNDS >= 2, "ASYNC_TCP_MAG_ROUNDS must be at least 2");
+        static_assert(BLOCKS <= UINT16_MAX, "ASYNC_TCP_MAG_BLOCKS too large");
+
+        constexpr std::size_t SIZES[CLASSES] = {16, 32, 64, 128};
+        constexpr std::size_t OFFSETS[CLASSES + 1] = {
+            0, BLOCKS * 16, BLOCKS * (16 + 32), BLOCKS * (16 + 32 + 64),
+            BLOCKS * (16 + 32 + 64 + 128)};
+
+        static_assert(SIZES[CLASSES - 1] == MagazineAllocator::MAX_SIZE,
+                      "MAX_SIZE must be the largest class");
+
+        struct FreeBlock {
+                FreeBlock *next;
+        };
+
+        /// One core's cache for one class; touched only by that core.
+        struct Magazine {
+                void *rounds[ROUNDS];
+                uint8_t count;
+                uint32_t allocations;
+                uint32_t frees;
+                uint32_t overflows;
+        };
+
+        /// Shared per class, under the depot lock.
+        struct Depot {
+                FreeBlock *free;
+                uint16_t bumped; ///< Arena blocks handed out at least once
+                uint32_t refills;
+                uint32_t returns;
+        };
+
+        // Zero-initialised, so usable before static constructors run.
+        alignas(8) unsigned char s_arena[OFFSETS[CLASSES]];
+        Magazine s_mags[NUM_CORES][CLASSES];
+        Depot s_depot[CLASSES];
+
+        spin_lock_t *depotLock() {
+            return spin_lock_instance(PICO_SPINLOCK_ID_STRIPED_FIRST + 1);
+        }
+
+        std::size_t classFor(const std::size_t size) {
+            std::size_t cls = 0;
+            while (cls < CLASSES && SIZES[cls] < size) {
+                ++cls;
+            }
+            return cls;
+        }
+
+        /// Class of an arena block, CLASSES for heap pointers.
+        std::size_t classOf(const void *p) {
+            const auto *c = static_cast<const unsigned char *>(p);
+            if (c < s_arena || c >= s_arena + sizeof(s_arena)) {
+                return CLASSES;
+            }
+            const auto offset = static_cast<std::size_t>(c - s_arena);
+            std::size_t cls = 0;
+            while (offset >= OFFSETS[cls + 1]) {
+                ++cls;
+            }
+            return cls;
+        }
+
+        // Interrupts are already masked by the callers.
+        void refill(const std::size_t cls, Magazine &m) {
+            Depot &d = s_depot[cls];
+            spin_lock_unsafe_blocking(depotLock());
+            while (m.count < BATCH && d.free) {
+                m.rounds[m.count++] = d.free;
+                d.free = d.free->next;
+            }
+            while (m.count < BATCH && d.bumped < BLOCKS) {
+                m.rounds[m.count++] =
+                    s_arena + OFFSETS[cls] + SIZES[cls] * d.bumped++;
+            }
+            if (m.count) {
+                ++d.refills;
+            }
+            spin_unlock_unsafe(depotLock());
+        }
+
+        void giveBack(const std::size_t cls, Magazine &m) {
+            Depot &d = s_depot[cls];
+            spin_lock_unsafe_blocking(depotLock());
+            for (std::size_t i = 0; i < BATCH; ++i) {
+                auto *b = static_cast<FreeBlock *>(m.rounds[--m.count]);
+                b->next = d.free;
+                d.free = b;
+            }
+            ++d.returns;
+            spin_unlock_unsafe(depotLock());
+        }
+
+    } // namespace
+
+    void *MagazineAllocator::allocate(const std::size_t size) {
+        if (const std::size_t cls = classFor(size); cls < CLASSES) {
+            const uint32_t irq = save_and_disable_interrupts();
+            Magazine &m = s_mags[get_core_num()][cls];
+            if (m.count == 0) {
+                refill(cls, m);
+            }
+            if (m.count) {
+                void *p = m.rounds[--m.count];
+                ++m.allocations;
+                restore_interrupts(irq);
+                return p;
+            }
+            ++m.overflows;
+            restore_interrupts(irq);
+        }
+        return ::operator new(size);
+    }
+
+    void MagazineAllocator::deallocate(void *p) {
+        if (!p) {
+            return;
+        }
+        const std::size_t cls = classOf(p);
+        if (cls == CLASSES) {
+            ::operator delete(p);
+            return;
+        }
+        const uint32_t irq = save_and_disable_interrupts();
+        Magazine &m = s_mags[get_core_num()][cls];
+        if (m.count == ROUNDS) {
+            giveBack(cls, m);
+        }
+        m.rounds[m.count++] = p;
+        ++m.frees;
+        restore_interrupts(irq);
+    }
+
+    MagazineAllocator::Stats MagazineAllocator::stats(const std::size_t cls) {
+        Stats s{};
+        if (cls >= CLASSES) {
+            return s;
+        }
+        s.block_size = static_cast<uint32_t>(SIZES[cls]);
+        s.capacity = static_cast<uint32_t>(BLOCKS);
+        // Per-core counters are read unlocked and may lag by an operation.
+        for (const auto &core : s_mags) {
+            s.allocations += core[cls].allocations;
+            s.frees += core[cls].frees;
+            s.overflows += core[cls].overflows;
+        }
+        const uint32_t save = spin_lock_blocking(depotLock());
+        s.depot_refills = s_depot[cls].refills;
+        s.depot_returns = s_depot[cls].returns;
+        s.high_water = s_depot[cls].bumped;
+        spin_unlock(depotLock(), save);
+        s.in_use = s.allocations - s.frees;
+        return s;
+    }
+
+    void MagazineAllocator::print(Print &out) {
+        for (std::size_t cls = 0; cls < CLASSES; ++cls) {
+            const Stats s = stats(cls);
+            out.printf("[mag] size=%lu cap=%lu used=%lu hwm=%lu allocs=%lu "
+                       "frees=%lu refills=%lu returns=%lu overflow=%lu\n",
+                       static_cast<unsigned long>(s.block_size),
+                       static_cast<unsigned long>(s.capacity),
+                       static_cast<unsigned long>(s.in_use),
+                       static_cast<unsigned long>(s.high_water),
+                       static_cast<unsigned long>(s.allocations),
+                       static_cast<unsigned long>(s.frees),
+                       static_cast<unsigned long>(s.depot_refills),
+                       static_cast<unsigned long>(s.depot_returns),
+                       static_cast<unsigned long>(s.overflows));
+        }
+    }
+
+} // namespace async_tcp
@@ -0,0 +1,521 @@
+/**
+ * @file MetricsServer.cpp
+ * @brief Incremental Prometheus text rendering over the lwIP raw API.
+ */
+
+#include "MetricsServer.hpp"
+
+#include "EventRecorder.hpp"
+#include "StageTimings.hpp"
+#include "TcpClient.hpp"
+#include "TcpClientContext.hpp"
+#include "TokenLog.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <lwip/memp.h>
+#include <lwip/stats.h>
+#include <malloc.h>
+
+namespace async_tcp {
+
+    namespace {
+
+        constexpr uint8_t POLL_INTERVAL = 4; // 2 s in TCP coarse ticks
+        constexpr uint8_t MAX_IDLE_POLLS = 5;
+
+        const char HTTP_HEADERS[] =
+            "HTTP/1.0 200 OK\r\n"
+            "Content-Type: text/plain; version=0.0.4\r\n"
+            "Connection: close\r\n\r\n";
+
+        struct GlobalMetric {
+                const char *name;
+                const char *help;
+                const char *type;
+                uint64_t (*get)(const MetricsServer &);
+        };
+
+        const GlobalMetric GLOBAL_METRICS[] = {
+            {"async_tcp_heap_used_bytes", "Heap bytes in use.", "gauge",
+             [](const MetricsServer &) -> uint64_t {
+                 return mallinfo().uordblks;
+             }},
+#if LWIP_STATS && TCP_STATS
+            {"async_tcp_lwip_tcp_rx_segments_total",
+             "TCP segments received by lwIP.", "counter",
+             [](const MetricsServer &) -> uint64_t {
+                 return lwip_stats.tcp.recv;
+             }},
+            {"async_tcp_lwip_tcp_tx_segments_total",
+             "TCP segments sent by lwIP.", "counter",
+             [](const MetricsServer &) -> uint64_t {
+                 return lwip_stats.tcp.xmit;
+             }},
+            {"async_tcp_lwip_tcp_drops_total", "TCP segments dropped by lwIP.",
+             "counter",
+             [](const MetricsServer &) -> uint64_t {
+                 return lwip_stats.tcp.drop;
+             }},
+            {"async_tcp_lwip_tcp_errors_total", "lwIP TCP errors.", "counter",
+             [](const MetricsServer &) -> uint64_t {
+                 return lwip_stats.tcp.err;
+             }},
+#endif
+            {"async_tcp_tokenlog_dropped_total",
+             "Tokenized log records dropped on full rings.", "counter",
+             [](const MetricsServer &) -> uint64_t {
+                 return TokenLog::dropped();
+             }},
+            {"async_tcp_event_recorder_dropped_total",
+             "Event records dropped on a full trace.", "counter",
+             [](const MetricsServer &) -> uint64_t {
+                 return EventRecorder::dropped();
+             }},
+            {"async_tcp_metrics_scrapes_total", "Metrics scrapes served.",
+             "counter",
+             [](const MetricsServer &s) -> uint64_t { return s.scrapes(); }},
+        };
+
+        struct ClientMetric {
+                const char *name;
+                const char *help;
+                const char *type;
+                uint64_t (*get)(const TcpClient &);
+        };
+
+        const ClientMetric CLIENT_METRICS[] = {
+            {"async_tcp_client_connected", "1 while the client has a context.",
+             "gauge",
+             [](const TcpClient &c) -> uint64_t {
+                 return c.getContext() ? 1 : 0;
+             }},
+            {"async_tcp_client_connects_total", "Completed connects.",
+             "counter",
+             [](const TcpClient &c) -> uint64_t {
+                 return c.getCounters().connects;
+             }},
+            {"async_tcp_client_fins_total", "FINs received.", "counter",
+             [](const TcpClient &c) -> uint64_t {
+                 return c.getCounters().fins;
+             }},
+            {"async_tcp_client_errors_total", "tcp_err callbacks.", "counter",
+             [](const TcpClient &c) -> uint64_t {
+                 return c.getCounters().errors;
+             }},
+            {"async_tcp_client_polls_total", "tcp_poll ticks.", "counter",
+             [](const TcpClient &c) -> uint64_t {
+                 return c.getCounters().polls;
+             }},
+            {"async_tcp_client_stalls_total",
+             "Polls with data in flight and no ACK since the previous poll.",
+             "counter",
+             [](const TcpClient &c) -> uint64_t {
+                 return c.getCounters().stalls;
+             }},
+            {"async_tcp_client_rx_bytes_total", "Bytes received.", "counter",
+             [](const TcpClient &c) -> uint64_t {
+                 return c.getCounters().rx_bytes;
+             }},
+            {"async_tcp_client_tx_bytes_total", "Bytes queued for sending.",
+             "counter",
+             [](const TcpClient &c) -> uint64_t {
+                 return c.getCounters().tx_bytes;
+             }},
+            {"async_tcp_client_tx_acked_bytes_total", "Bytes ACKed by peers.",
+             "counter",
+             [](const TcpClient &c) -> uint64_t {
+                 return c.getCounters().tx_acked_bytes;
+             }},
+        };
+
+        constexpr uint8_t GLOBAL_COUNT =
+            sizeof(GLOBAL_METRICS) / sizeof(GLOBAL_METRICS[0]);
+        constexpr uint8_t CLIENT_COUNT =
+            sizeof(CLIENT_METRICS) / sizeof(CLIENT_METRICS[0]);
+
+#if LWIP_STATS && MEMP_STATS
+        const char *const POOL_NAMES[] = {
+#define LWIP_MEMPOOL(name, num, size, desc) #name,
+#include <lwip/priv/memp_std.h>
+        };
+
+        struct MempMetric {
+                const char *name;
+                const char *help;
+                uint32_t (*get)(const stats_mem &);
+        };
+
+        const MempMetric MEMP_METRICS[] = {
+            {"async_tcp_lwip_memp_used", "lwIP pool elements in use.",
+             [](const stats_mem &s) -> uint32_t { return s.used; }},
+            {"async_tcp_lwip_memp_max", "lwIP pool high-water mark.",
+             [](const stats_mem &s) -> uint32_t { return s.max; }},
+            {"async_tcp_lwip_memp_avail", "lwIP pool size.",
+             [](const stats_mem &s) -> uint32_t { return s.avail; }},
+        };
+
+        constexpr uint8_t MEMP_COUNT =
+            sizeof(MEMP_METRICS) / sizeof(MEMP_METRICS[0]);
+#endif
+
+        constexpr const char *STAGE_METRIC = "async_tcp_stage_latency_us";
+        constexpr uint8_t STAGE_LINES = 5; // three quantiles, sum, count
+        const float QUANTILES[] = {0.5f, 0.9f, 0.99f};
+
+    } // namespace
+
+    bool MetricsServer::begin(const uint16_t port) {
+        if (m_listen) {
+            return false;
+        }
+        tcp_pcb *pcb = tcp_new_ip_type(IPADDR_TYPE_ANY);
+        if (!pcb) {
+            return false;
+        }
+        if (tcp_bind(pcb, IP_ANY_TYPE, port) != ERR_OK) {
+            tcp_close(pcb);
+            return false;
+        }
+        m_listen = tcp_listen(pcb);
+        if (!m_listen) {
+            tcp_close(pcb);
+            return false;
+        }
+        tcp_arg(m_listen, this);
+        tcp_accept(m_listen, &MetricsServer::s_accept);
+        return true;
+    }
+
+    void MetricsServer::end() {
+        for (auto &c : m_conns) {
+            if (c.pcb) {
+                release(c, true);
+            }
+        }
+        if (m_listen) {
+            tcp_arg(m_listen, nullptr);
+            tcp_accept(m_listen, nullptr);
+            tcp_close(m_listen);
+            m_listen = nullptr;
+        }
+    }
+
+    bool MetricsServer::addClient(const TcpClient *client) {
+        for (auto &slot : m_clients) {
+            if (!slot) {
+                slot = client;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void MetricsServer::removeClient(const TcpClient *client) {
+        for (auto &slot : m_clients) {
+            if (slot == client) {
+                slot = nullptr;
+            }
+        }
+    }
+
+    const TcpClient *MetricsServer::clientAt(uint16_t n) const {
+        for (const auto *client : m_clients) {
+            if (client && n-- == 0) {
+                return client;
+            }
+        }
+        return nullptr;
+    }
+
+    err_t MetricsServer::s_accept(void *arg, tcp_pcb *pcb, const err_t err) {
+        if (err != ERR_OK || !pcb || !arg) {
+            return ERR_VAL;
+        }
+        auto &self = *static_cast<MetricsServer *>(arg);
+        for (auto &c : self.m_conns) {
+            if (c.pcb) {
+                continue;
+            }
+            c = Conn{};
+            c.owner = &self;
+            c.pcb = pcb;
+            tcp_arg(pcb, &c);
+            tcp_recv(pcb, &MetricsServer::s_recv);
+            tcp_sent(pcb, &MetricsServer::s_sent);
+            tcp_err(pcb, &MetricsServer::s_error);
+            tcp_poll(pcb, &MetricsServer::s_poll, POLL_INTERVAL);
+            return ERR_OK;
+        }
+        tcp_abort(pcb);
+        return ERR_ABRT;
+    }
+
+    err_t MetricsServer::s_recv(void *arg, tcp_pcb *pcb, pbuf *p,
+                                const err_t err) {
+        auto *c = static_cast<Conn *>(arg);
+        if (!c) {
+            if (p) {
+                pbuf_free(p);
+            }
+            return ERR_OK;
+        }
+        if (err != ERR_OK || !p) {
+            if (p) {
+                pbuf_free(p);
+            }
+            return c->owner->release(*c, false);
+        }
+
+        // The request itself is irrelevant: every path gets the metrics.
+        tcp_recved(pcb, p->tot_len);
+        pbuf_free(p);
+        c->idle_polls = 0;
+        if (c->requested) {
+            return ERR_OK;
+        }
+        c->requested = true;
+        ++c->owner->m_scrapes;
+        return c->owner->pump(*c);
+    }
+
+    err_t MetricsServer::s_sent(void *arg, tcp_pcb *pcb, const u16_t len) {
+        (void)pcb;
+        (void)len;
+        auto *c = static_cast<Conn *>(arg);
+        if (!c || !c->requested) {
+            return ERR_OK;
+        }
+        c->idle_polls = 0;
+        return c->owner->pump(*c);
+    }
+
+    void MetricsServer::s_error(void *arg, const err_t err) {
+        (void)err;
+        if (auto *c = static_cast<Conn *>(arg)) {
+            c->pcb = nullptr; // already freed by lwIP
+        }
+    }
+
+    err_t MetricsServer::s_poll(void *arg, tcp_pcb *pcb) {
+        (void)pcb;
+        auto *c = static_cast<Conn *>(arg);
+        if (c && ++c->idle_polls > MAX_IDLE_POLLS) {
+            return c->owner->release(*c, true);
+        }
+        return ERR_OK;
+    }
+
+    err_t MetricsServer::pump(Conn &c) {
+        for (;;) {
+            if (!c.line_len && !nextLine(c)) {
+                // Body complete; the FIN follows the queued data.
+                tcp_output(c.pcb);
+                return release(c, false);
+            }
+            if (tcp_sndbuf(c.pcb) < c.line_len ||
+                tcp_sndqueuelen(c.pcb) + 2 > TCP_SND_QUEUELEN) {
+                break; // resume from s_sent
+            }
+            if (tcp_write(c.pcb, c.line, c.line_len,
+                          TCP_WRITE_FLAG_COPY | TCP_WRITE_FLAG_MORE) !=
+                ERR_OK) {
+                break;
+            }
+            c.line_len = 0;
+        }
+        tcp_output(c.pcb);
+        return ERR_OK;
+    }
+
+    err_t MetricsServer::release(Conn &c, const bool abort) {
+        err_t res = ERR_OK;
+        if (c.pcb) {
+            tcp_arg(c.pcb, nullptr);
+            tcp_recv(c.pcb, nullptr);
+            tcp_sent(c.pcb, nullptr);
+            tcp_err(c.pcb, nullptr);
+            tcp_poll(c.pcb, nullptr, 0);
+            if (abort || tcp_close(c.pcb) != ERR_OK) {
+                tcp_abort(c.pcb);
+                res = ERR_ABRT; // callers inside lwIP callbacks return this
+            }
+            c.pcb = nullptr;
+        }
+        return res;
+    }
+
+    int MetricsServer::header(Conn &c, const char *name, const char *help,
+                              const char *type) {
+        if (c.cursor.item == 0) {
+            return snprintf(c.line, LINE_SIZE, "# HELP %s %s\n", name, help);
+        }
+        return snprintf(c.line, LINE_SIZE, "# TYPE %s %s\n", name, type);
+    }
+
+    bool MetricsServer::nextLine(Conn &c) {
+        auto &cur = c.cursor;
+        for (;;) {
+            bool produced = false;
+            switch (cur.section) {
+            case Section::Headers:
+                if (cur.item == 0) {
+                    snprintf(c.line, LINE_SIZE, "%s", HTTP_HEADERS);
+                    ++cur.item;
+                    produced = true;
+                }
+                break;
+            case Section::Global:
+                produced = globalLine(c);
+                break;
+            case Section::Client:
+                produced = clientLine(c);
+                break;
+            case Section::Memp:
+                produced = mempLine(c);
+                break;
+            case Section::Stages:
+                produced = stageLine(c);
+                break;
+            case Section::Done:
+                return false;
+            }
+
+            if (produced) {
+                // snprintf truncates, so this is always < LINE_SIZE.
+                c.line_len = static_cast<uint8_t>(strlen(c.line));
+                return true;
+            }
+            cur.section =
+                static_cast<Section>(static_cast<uint8_t>(cur.section) + 1);
+            cur.family = 0;
+            cur.item = 0;
+        }
+    }
+
+    bool MetricsServer::globalLine(Conn &c) {
+        auto &cur = c.cursor;
+        while (cur.family < GLOBAL_COUNT) {
+            const auto &m = GLOBAL_METRICS[cur.family];
+            if (cur.item < 2) {
+                header(c, m.name, m.help, m.type);
+                ++cur.item;
+                return true;
+            }
+            if (cur.item == 2) {
+                snprintf(c.line, LINE_SIZE, "%s %llu\n", m.name,
+                         static_cast<unsigned long long>(m.get(*this)));
+                ++cur.item;
+                return true;
+            }
+            ++cur.family;
+            cur.item = 0;
+        }
+        return false;
+    }
+
+    bool MetricsServer::clientLine(Conn &c) {
+        auto &cur = c.cursor;
+        while (cur.family < CLIENT_COUNT && clientAt(0)) {
+            const auto &m = CLIENT_METRICS[cur.family];
+            if (cur.item < 2) {
+                header(c, m.name, m.help, m.type);
+                ++cur.item;
+                return true;
+            }
+            if (const auto *client = clientAt(cur.item - 2)) {
+                snprintf(c.line, LINE_SIZE, "%s{client=\"%u\"} %llu\n", m.name,
+                         client->getClientId(),
+                         static_cast<unsigned long long>(m.get(*client)));
+                ++cur.item;
+                return true;
+            }
+            ++cur.family;
+            cur.item = 0;
+        }
+        return false;
+    }
+
+    bool MetricsServer::mempLine(Conn &c) {
+#if LWIP_STATS && MEMP_STATS
+        auto &cur = c.cursor;
+        while (cur.family < MEMP_COUNT) {
+            const auto &m = MEMP_METRICS[cur.family];
+            if (cur.item < 2) {
+                header(c, m.name, m.help, "gauge");
+                ++cur.item;
+                return true;
+            }
+            const auto pool = cur.item - 2;
+            if (pool < MEMP_MAX) {
+                ++cur.item;
+                if (const auto *stats = lwip_stats.memp[pool]) {
+                    snprintf(c.line, LINE_SIZE, "%s{pool=\"%s\"} %lu\n",
+                             m.name, POOL_NAMES[pool],
+                             static_cast<unsigned long>(m.get(*stats)));
+                    return true;
+                }
+                continue;
+            }
+            ++cur.family;
+            cur.item = 0;
+        }
+#else
+        (void)c;
+#endif
+        return false;
+    }
+
+    bool MetricsServer::stageLine(Conn &c) {
+        auto &cur = c.cursor;
+        constexpr uint16_t PER_CLIENT = StageTimings::STAGES * STAGE_LINES;
+
+        if (cur.item < 2) {
+            header(c, STAGE_METRIC,
+                   "Per-stage RX/TX latency, see StageTimings.", "summary");
+            ++cur.item;
+            return true;
+        }
+        for (;;) {
+            const uint16_t n = cur.item - 2;
+            const auto *client = clientAt(n / PER_CLIENT);
+            if (!client) {
+                return false;
+            }
+            const auto *timings = client->getStageTimings();
+            if (!timings) {
+                cur.item += PER_CLIENT - n % PER_CLIENT; // next client
+                continue;
+            }
+            const uint16_t rem = n % PER_CLIENT;
+            const auto stage = static_cast<StageTimings::Stage>(
+                rem / STAGE_LINES);
+            const uint8_t line = rem % STAGE_LINES;
+            const auto h = timings->snapshot(stage);
+            const unsigned id = client->getClientId();
+            const char *stage_name = StageTimings::name(stage);
+
+            if (line < 3) {
+                snprintf(c.line, LINE_SIZE,
+                         "%s{client=\"%u\",stage=\"%s\",quantile=\"%g\"} %lu\n",
+                         STAGE_METRIC, id, stage_name,
+                         static_cast<double>(QUANTILES[line]),
+                         static_cast<unsigned long>(
+                             h.percentile(QUANTILES[line] * 100.0f)));
+            } else if (line == 3) {
+                snprintf(c.line, LINE_SIZE,
+                         "%s_sum{client=\"%u\",stage=\"%s\"} %llu\n",
+                         STAGE_METRIC, id, stage_name,
+                         static_cast<unsigned long long>(h.sum_us));
+            } else {
+                snprintf(c.line, LINE_SIZE,
+                         "%s_count{client=\"%u\",stage=\"%s\"} %lu\n",
+                         STAGE_METRIC, id, stage_name,
+                         static_cast<unsigned long>(h.count));
+            }
+            ++cur.item;
+            return true;
+        }
+    }
+
+} // namespace async_tcp
@@ -0,0 +1,240 @@
+/**
+ * @file NetifImpairment.cpp
+ * @brief Delay queue, loss/reorder decisions and window rewriting for
+ * NetifImpairment.
+ */
+
+#include "NetifImpairment.hpp"
+
+#include <lwip/prot/ethernet.h>
+#include <lwip/prot/ip4.h>
+#include <lwip/prot/tcp.h>
+#include <pico/time.h>
+
+namespace async_tcp {
+
+    NetifImpairment *NetifImpairment::s_instance = nullptr;
+
+    namespace {
+
+        bool isDue(const uint32_t due_us, const uint32_t now_us) {
+            return static_cast<int32_t>(now_us - due_us) >= 0;
+        }
+
+        /**
+         * @brief RFC 1624 incremental update of a one's complement checksum.
+         */
+        uint16_t adjustChecksum(const uint16_t sum, const uint16_t old_word,
+                                const uint16_t new_word) {
+            uint32_t acc = static_cast<uint16_t>(~sum);
+            acc += static_cast<uint16_t>(~old_word);
+            acc += new_word;
+            acc = (acc & 0xFFFF) + (acc >> 16);
+            acc = (acc & 0xFFFF) + (acc >> 16);
+            return static_cast<uint16_t>(~acc);
+        }
+
+    } // namespace
+
+    NetifImpairment::NetifImpairment(const uint32_t seed) { reseed(seed); }
+
+    bool NetifImpairment::attach(netif *nif) {
+        if (!nif || s_instance) {
+            return false;
+        }
+        m_netif = nif;
+        m_input = nif->input;
+        m_linkoutput = nif->linkoutput;
+        nif->input = &NetifImpairment::s_input;
+        nif->linkoutput = &NetifImpairment::s_linkoutput;
+        s_instance = this;
+        return true;
+    }
+
+    void NetifImpairment::detach() {
+        if (!m_netif || s_instance != this) {
+            return;
+        }
+        m_netif->input = m_input;
+        m_netif->linkoutput = m_linkoutput;
+        s_instance = nullptr;
+
+        // Deliver what is still in flight; dropping it would turn a detach
+        // into an extra loss event.
+        for (std::size_t i = 0; i < m_used; ++i) {
+            deliver(m_queue[i].dir, m_queue[i].p);
+        }
+        m_used = 0;
+        m_netif = nullptr;
+    }
+
+    void NetifImpairment::setProfile(const Direction dir,
+                                     const ImpairmentProfile &profile) {
+        m_profile[static_cast<uint8_t>(dir)] = profile;
+    }
+
+    void NetifImpairment::reseed(const uint32_t seed) {
+        m_rng = seed ? seed : 1;
+        m_stats[0] = {};
+        m_stats[1] = {};
+    }
+
+    uint32_t NetifImpairment::next() {
+        m_rng ^= m_rng << 13;
+        m_rng ^= m_rng >> 17;
+        m_rng ^= m_rng << 5;
+        return m_rng;
+    }
+
+    bool NetifImpairment::chance(const uint32_t ppm) {
+        return ppm && next() % 1000000 < ppm;
+    }
+
+    err_t NetifImpairment::s_input(pbuf *p, netif *nif) {
+        (void)nif;
+        return s_instance->impair(Direction::Ingress, p);
+    }
+
+    err_t NetifImpairment::s_linkoutput(netif *nif, pbuf *p) {
+        (void)nif;
+        // linkoutput does not take ownership and lwIP may reuse segment
+        // buffers for retransmission, so delayed frames travel as a copy.
+        pbuf *copy = pbuf_clone(PBUF_RAW, PBUF_RAM, p);
+        if (!copy) {
+            return ERR_MEM;
+        }
+        s_instance->impair(Direction::Egress, copy);
+        return ERR_OK;
+    }
+
+    err_t NetifImpairment::impair(const Direction dir, pbuf *p) {
+        poll();
+
+        const auto d = static_cast<uint8_t>(dir);
+        const auto &prof = m_profile[d];
+        auto &stats = m_stats[d];
+
+        if (chance(prof.loss_ppm)) {
+            ++stats.dropped;
+            pbuf_free(p);
+            return ERR_OK;
+        }
+
+        if (dir == Direction::Ingress && prof.zero_window) {
+            rewriteWindow(p);
+        }
+
+        const uint32_t now = time_us_32();
+        uint32_t depart = now;
+        if (prof.rate_bps) {
+            // Serialise frames on the emulated link from their departure
+            // time: each one starts when the previous one has left.
+            if (!isDue(m_link_free_us[d], depart)) {
+                depart = m_link_free_us[d];
+            }
+            depart += static_cast<uint32_t>(
+                static_cast<uint64_t>(p->tot_len) * 8 * 1000000 /
+                prof.rate_bps);
+            m_link_free_us[d] = depart;
+        }
+
+        // Latency, jitter and reorder hold-back apply after the link, so a
+        // held frame does not delay the ones serialised behind it.
+        uint32_t delay = prof.latency_us;
+        if (prof.jitter_us) {
+            delay += next() % (prof.jitter_us + 1);
+        }
+        if (chance(prof.reorder_ppm)) {
+            delay += prof.reorder_us;
+            ++stats.reordered;
+        }
+        const uint32_t due = depart + delay;
+
+        if (isDue(due, now)) {
+            deliver(dir, p);
+            return ERR_OK;
+        }
+
+        if (m_used == ASYNC_TCP_IMPAIR_QUEUE_LEN) {
+            ++stats.queue_full;
+            pbuf_free(p);
+            return ERR_OK;
+        }
+        m_queue[m_used++] = {p, due, dir};
+        return ERR_OK;
+    }
+
+    void NetifImpairment::poll() {
+        const uint32_t now = time_us_32();
+        // Release in due-time order so held back frames really are
+        // overtaken; the queue is short, a selection pass is cheap.
+        while (m_used) {
+            std::size_t pick = m_used;
+            for (std::size_t i = 0; i < m_used; ++i) {
+                if (isDue(m_queue[i].due_us, now) &&
+                    (pick == m_used ||
+                     static_cast<int32_t>(m_queue[i].due_us -
+                                          m_queue[pick].due_us) < 0)) {
+                    pick = i;
+                }
+            }
+            if (pick == m_used) {
+                return;
+            }
+            const Slot slot = m_queue[pick];
+            m_queue[pick] = m_queue[--m_used];
+            deliver(slot.dir, slot.p);
+        }
+    }
+
+    void NetifImpairment::deliver(const Direction dir, pbuf *p) {
+        ++m_stats[static_cast<uint8_t>(dir)].passed;
+        if (dir == Direction::Ingress) {
+            if (m_input(p, m_netif) != ERR_OK) {
+                pbuf_free(p);
+            }
+        } else {
+            m_linkoutput(m_netif, p);
+            pbuf_free(p);
+        }
+    }
+
+    void NetifImpairment::rewriteWindow(pbuf *p) {
+        std::size_t offset = 0;
+        auto *bytes = static_cast<uint8_t *>(p->payload);
+
+        if (m_netif->flags & NETIF_FLAG_ETHERNET) {
+            if (p->len < SIZEOF_ETH_HDR) {
+                return;
+            }
+            const auto *eth = reinterpret_cast<const eth_hdr *>(bytes);
+            if (eth->type != PP_HTONS(ETHTYPE_IP)) {
+                return;
+            }
+            offset = SIZEOF_ETH_HDR;
+        }
+
+        if (p->len < offset + IP_HLEN) {
+            return;
+        }
+        const auto *ip = reinterpret_cast<const ip_hdr *>(bytes + offset);
+        if (IPH_V(ip) != 4 || IPH_PROTO(ip) != IP_PROTO_TCP ||
+            (IPH_OFFSET(ip) & PP_HTONS(IP_OFFMASK)) != 0) {
+            return;
+        }
+        offset += IPH_HL_BYTES(ip);
+
+        // The TCP header must sit in the first pbuf to be patched in place.
+        if (p->len < offset + TCP_HLEN) {
+            return;
+        }
+        auto *tcp = reinterpret_cast<tcp_hdr *>(bytes + offset);
+        if (tcp->wnd == 0) {
+            return;
+        }
+        tcp->chksum = adjustChecksum(tcp->chksum, tcp->wnd, 0);
+        tcp->wnd = 0;
+        ++m_stats[static_cast<uint8_t>(Direction::Ingress)].window_rewrites;
+    }
+
+} // namespace async_tcp
@@ -0,0 +1,185 @@
+/**
+ * @file PriorityScheduler.cpp
+ * @brief Strict-priority draining of the scheduler queues.
+ */
+
+#include "PriorityScheduler.hpp"
+
+namespace async_tcp {
+
+    PriorityScheduler::PriorityScheduler(async_context_t *ctx) : m_ctx(ctx) {
+        m_worker.do_work = &PriorityScheduler::s_do_work;
+        m_worker.user_data = this;
+        async_context_add_when_pending_worker(m_ctx, &m_worker);
+    }
+
+    PriorityScheduler::~PriorityScheduler() {
+        async_context_remove_when_pending_worker(m_ctx, &m_worker);
+    }
+
+    bool PriorityScheduler::post(const Priority priority,
+                                 ScheduledHandler *handler, TcpClient *client,
+                                 const int32_t value, const bool coalesce,
+                                 const ClientHandle handle) {
+        const auto cls = static_cast<uint8_t>(priority);
+        Queue &q = m_queues[cls];
+
+        if (coalesce) {
+            for (uint8_t i = 0; i < q.count; ++i) {
+                Task &t = q.tasks[(q.head + i) % ASYNC_TCP_SCHED_QUEUE];
+                if (t.handler == handler && t.client == client &&
+                    t.handle == handle) {
+                    t.value += value;
+                    ++m_stats.coalesced;
+                    return true;
+                }
+            }
+        }
+        if (q.count == ASYNC_TCP_SCHED_QUEUE) {
+            ++m_stats.dropped;
+            return false;
+        }
+        q.tasks[(q.head + q.count) % ASYNC_TCP_SCHED_QUEUE] = {handler, client,
+                                                               value, handle};
+        ++q.count;
+        if (q.count > m_stats.max_depth[cls]) {
+            m_stats.max_depth[cls] = q.count;
+        }
+        async_context_set_work_pending(m_ctx, &m_worker);
+        return true;
+    }
+
+    bool PriorityScheduler::promote(const TcpClient *client) {
+        Queue &critical =
+            m_queues[static_cast<uint8_t>(Priority::Critical)];
+        uint8_t found = 0;
+        for (uint8_t cls = 1; cls < CLASSES; ++cls) {
+            const Queue &q = m_queues[cls];
+            for (uint8_t i = 0; i < q.count; ++i) {
+                if (q.tasks[(q.head + i) % ASYNC_TCP_SCHED_QUEUE].client ==
+                    client) {
+                    ++found;
+                }
+            }
+        }
+        if (critical.count + found + 1 > ASYNC_TCP_SCHED_QUEUE) {
+            return false;
+        }
+        for (uint8_t cls = 1; cls < CLASSES; ++cls) {
+            Queue &q = m_queues[cls];
+            uint8_t kept = 0;
+            for (uint8_t i = 0; i < q.count; ++i) {
+                const Task t = q.tasks[(q.head + i) % ASYNC_TCP_SCHED_QUEUE];
+                if (t.client != client) {
+                    q.tasks[(q.head + kept++) % ASYNC_TCP_SCHED_QUEUE] = t;
+                    continue;
+                }
+                critical.tasks[(critical.head + critical.count++) %
+                               ASYNC_TCP_SCHED_QUEUE] = t;
+                ++m_stats.promoted;
+            }
+            q.count = kept;
+        }
+        auto &depth = m_stats.max_depth[static_cast<uint8_t>(
+            Priority::Critical)];
+        if (critical.count > depth) {
+            depth = critical.count;
+        }
+        return true;
+    }
+
+    void PriorityScheduler::runPending(const TcpClient *client,
+                                       const ScheduledHandler *handler) {
+        // One task at a time, oldest class first (promoted tasks are older
+        // than what is still in the data queues); taken out before it runs,
+        // as the handler may post or close again.
+        for (;;) {
+            Task t{};
+            uint8_t cls = 0;
+            bool found = false;
+            for (; cls < CLASSES && !found; ++cls) {
+                Queue &q = m_queues[cls];
+                uint8_t kept = 0;
+                for (uint8_t i = 0; i < q.count; ++i) {
+                    const Task u =
+                        q.tasks[(q.head + i) % ASYNC_TCP_SCHED_QUEUE];
+                    if (!found && u.client == client && u.handler == handler) {
+                        t = u;
+                        found = true;
+                    } else {
+                        q.tasks[(q.head + kept++) % ASYNC_TCP_SCHED_QUEUE] = u;
+                    }
+                }
+                q.count = kept;
+            }
+            if (!found) {
+                return;
+            }
+            if (t.handle && m_handles && !m_handles->isCurrent(t.handle)) {
+                ++m_stats.stale;
+                continue;
+            }
+            ++m_stats.dispatched[cls - 1];
+            t.handler->onEvent(*t.client, t.value);
+        }
+    }
+
+    void PriorityScheduler::cancel(const TcpClient *client) {
+        for (auto &q : m_queues) {
+            uint8_t kept = 0;
+            for (uint8_t i = 0; i < q.count; ++i) {
+                const Task t = q.tasks[(q.head + i) % ASYNC_TCP_SCHED_QUEUE];
+                if (t.client != client) {
+                    q.tasks[(q.head + kept++) % ASYNC_TCP_SCHED_QUEUE] = t;
+                }
+            }
+            q.count = kept;
+        }
+    }
+
+    void PriorityScheduler::s_do_work(async_context_t *ctx,
+                                      async_when_pending_worker_t *worker) {
+        (void)ctx;
+        static_cast<PriorityScheduler *>(worker->user_data)->drain();
+    }
+
+    bool PriorityScheduler::runOne(const Priority priority) {
+        const auto cls = static_cast<uint8_t>(priority);
+        Queue &q = m_queues[cls];
+        if (!q.count) {
+            return false;
+        }
+        // Pop before running: the handler may post again.
+        const Task t = q.tasks[q.head];
+        q.head = (q.head + 1) % ASYNC_TCP_SCHED_QUEUE;
+        --q.count;
+        if (t.handle && m_handles && !m_handles->isCurrent(t.handle)) {
+            ++m_stats.stale;
+            return true;
+        }
+        ++m_stats.dispatched[cls];
+        t.handler->onEvent(*t.client, t.value);
+        return true;
+    }
+
+    void PriorityScheduler::drain() {
+        uint8_t bulk = 0;
+        for (;;) {
+            // Re-check the higher classes after every task: handlers may
+            // post critical work.
+            if (runOne(Priority::Critical) || runOne(Priority::Interactive)) {
+                continue;
+            }
+            if (bulk == m_bulk_batch) {
+                break;
+            }
+            if (!runOne(Priority::Bulk)) {
+                return;
+            }
+            ++bulk;
+        }
+        // Bulk work left: yield to lwIP and come back in the next pass.
+        async_context_set_work_pending(m_ctx, &m_worker);
+    }
+
+} // namespace async_tcp
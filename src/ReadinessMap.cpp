@@ -0,0 +1,81 @@
+/**
+ * @file ReadinessMap.cpp
+ * @brief Locked bit updates and the __wfe() wait loop.
+ */
+
+#include "ReadinessMap.hpp"
+
+#include <cassert>
+#include <hardware/sync.h>
+#include <pico/time.h>
+
+namespace async_tcp {
+
+    ReadinessMap::ReadinessMap()
+        : m_lock(spin_lock_instance(spin_lock_claim_unused(true))) {}
+
+    ReadinessMap::~ReadinessMap() {
+        spin_lock_unclaim(spin_lock_get_num(m_lock));
+    }
+
+    void ReadinessMap::set(const uint8_t client_id, const Kind kind,
+                           const bool on) {
+        assert(client_id < MAX_CLIENTS && "client id out of range");
+        if (client_id >= MAX_CLIENTS) {
+            return;
+        }
+        auto &word = m_bits[static_cast<uint8_t>(kind)];
+        const uint32_t bit = 1UL << client_id;
+        const uint32_t save = spin_lock_blocking(m_lock);
+        const uint32_t old = word.load(std::memory_order_relaxed);
+        const uint32_t next = on ? (old | bit) : (old & ~bit);
+        if (next != old) {
+            word.store(next, std::memory_order_release);
+            publish();
+        }
+        spin_unlock(m_lock, save);
+    }
+
+    void ReadinessMap::clear(const uint8_t client_id) {
+        if (client_id >= MAX_CLIENTS) {
+            return;
+        }
+        const uint32_t keep = ~(1UL << client_id);
+        const uint32_t save = spin_lock_blocking(m_lock);
+        for (auto &word : m_bits) {
+            word.store(word.load(std::memory_order_relaxed) & keep,
+                       std::memory_order_release);
+        }
+        publish();
+        spin_unlock(m_lock, save);
+    }
+
+    // Called with m_lock held.
+    void ReadinessMap::publish() {
+        const uint32_t pending =
+            ready(Kind::Readable) | ready(Kind::Hangup) | ready(Kind::Error);
+        m_pending.store(pending, std::memory_order_release);
+        __sev();
+    }
+
+    uint32_t ReadinessMap::waitAny(const uint32_t mask,
+                                   const uint32_t timeout_us,
+                                   const bool include_writable) const {
+        const absolute_time_t deadline = make_timeout_time_us(timeout_us);
+        for (;;) {
+            uint32_t hit = pending();
+            if (include_writable) {
+                hit |= ready(Kind::Writable);
+            }
+            hit &= mask;
+            if (hit) {
+                return hit;
+            }
+            if (time_reached(deadline)) {
+                return 0;
+            }
+            best_effort_wfe_or_timeout(deadline);
+        }
+    }
+
+} // namespace async_tcp
@@ -0,0 +1,161 @@
+/**
+ * @file ScheduledWriter.cpp
+ * @brief Deadline queue and at-time worker for ScheduledWriter.
+ */
+
+#include "ScheduledWriter.hpp"
+
+#include "TcpClient.hpp"
+#include "TcpClientContext.hpp"
+#include <cstring>
+
+namespace async_tcp {
+
+    // A slot must go out in one tcp_write() to be all-or-nothing.
+    static_assert(ASYNC_TCP_SCHED_WRITE_BYTES <= TCP_MSS,
+                  "ASYNC_TCP_SCHED_WRITE_BYTES must not exceed TCP_MSS");
+
+    ScheduledWriter::ScheduledWriter(async_context_t *ctx) : m_ctx(ctx) {
+        m_worker.do_work = &ScheduledWriter::s_do_work;
+        m_worker.user_data = this;
+    }
+
+    ScheduledWriter::~ScheduledWriter() {
+        async_context_acquire_lock_blocking(m_ctx);
+        if (m_armed) {
+            async_context_remove_at_time_worker(m_ctx, &m_worker);
+        }
+        async_context_release_lock(m_ctx);
+    }
+
+    bool ScheduledWriter::schedule(TcpClient &client,
+                                   const absolute_time_t deadline,
+                                   const uint8_t *data,
+                                   const std::size_t size) {
+        const uint64_t deadline_us = to_us_since_boot(deadline);
+
+        async_context_acquire_lock_blocking(m_ctx);
+        if (!data || size == 0 || size > ASYNC_TCP_SCHED_WRITE_BYTES ||
+            m_count == ASYNC_TCP_SCHED_WRITES) {
+            ++m_stats.rejected;
+            async_context_release_lock(m_ctx);
+            return false;
+        }
+        // Insertion sort; equal deadlines keep submission order.
+        uint8_t i = m_count;
+        while (i && m_pending[i - 1].deadline_us > deadline_us) {
+            m_pending[i] = m_pending[i - 1];
+            --i;
+        }
+        Pending &p = m_pending[i];
+        p.client = &client;
+        p.deadline_us = deadline_us;
+        p.size = static_cast<uint16_t>(size);
+        std::memcpy(p.data, data, size);
+        ++m_count;
+        ++m_stats.scheduled;
+        if (i == 0) {
+            arm(); // new earliest deadline
+        }
+        async_context_release_lock(m_ctx);
+        return true;
+    }
+
+    void ScheduledWriter::cancel(const TcpClient &client) {
+        async_context_acquire_lock_blocking(m_ctx);
+        uint8_t kept = 0;
+        for (uint8_t i = 0; i < m_count; ++i) {
+            if (m_pending[i].client != &client) {
+                m_pending[kept++] = m_pending[i];
+            }
+        }
+        m_count = kept;
+        arm();
+        async_context_release_lock(m_ctx);
+    }
+
+    void ScheduledWriter::arm() {
+        if (m_armed) {
+            async_context_remove_at_time_worker(m_ctx, &m_worker);
+            m_armed = false;
+        }
+        if (m_count) {
+            async_context_add_at_time_worker_at(
+                m_ctx, &m_worker, from_us_since_boot(m_pending[0].deadline_us));
+            m_armed = true;
+        }
+    }
+
+    void ScheduledWriter::s_do_work(async_context_t *ctx,
+                                    async_at_time_worker_t *worker) {
+        (void)ctx;
+        auto *self = static_cast<ScheduledWriter *>(worker->user_data);
+        self->m_armed = false; // at-time workers are one-shot
+        self->fire();
+    }
+
+    void ScheduledWriter::fire() {
+        uint8_t done = 0;
+        while (done < m_count) {
+            Pending &p = m_pending[done];
+            if (time_us_64() < p.deadline_us) {
+                break;
+            }
+            ++done;
+
+            TcpWriter *tx = p.client->_ctx ? p.client->_ctx->getTxWriter()
+                                           : nullptr;
+            // Only write what fits whole: with room for all of it,
+            // writeData() makes a single tcp_write(), so a slot is sent or
+            // failed, never half sent. The slot is reused right after, so
+            // lwIP must copy it. writeData() calls tcp_output() itself.
+            if (!tx || tx->availableForWrite() < p.size ||
+                tx->writeData(p.data, p.size, true) != p.size) {
+                ++m_stats.failed;
+                continue;
+            }
+            const uint64_t late = time_us_64() - p.deadline_us;
+            const auto late_us =
+                static_cast<uint32_t>(late > UINT32_MAX ? UINT32_MAX : late);
+            m_jitter.record(late_us);
+            ++m_stats.sent;
+            if (late_us > m_stats.max_late_us) {
+                m_stats.max_late_us = late_us;
+            }
+        }
+        for (uint8_t i = done; i < m_count; ++i) {
+            m_pending[i - done] = m_pending[i];
+        }
+        m_count -= done;
+        arm();
+    }
+
+    ScheduledWriter::Stats ScheduledWriter::stats() const {
+        async_context_acquire_lock_blocking(m_ctx);
+        const Stats s = m_stats;
+        async_context_release_lock(m_ctx);
+        return s;
+    }
+
+    void ScheduledWriter::resetStats() {
+        async_context_acquire_lock_blocking(m_ctx);
+        m_stats = {};
+        m_jitter.reset();
+        async_context_release_lock(m_ctx);
+    }
+
+    void ScheduledWriter::print(Print &out) const {
+        const Stats s = stats();
+        const auto j = jitter();
+        out.printf("[writeAt] sched=%lu sent=%lu failed=%lu rejected=%lu "
+                   "late us p50=%lu p99=%lu max=%lu\n",
+                   static_cast<unsigned long>(s.scheduled),
+                   static_cast<unsigned long>(s.sent),
+                   static_cast<unsigned long>(s.failed),
+                   static_cast<unsigned long>(s.rejected),
+                   static_cast<unsigned long>(j.percentile(50)),
+                   static_cast<unsigned long>(j.percentile(99)),
+                   static_cast<unsigned long>(j.max_us));
+    }
+
+} // namespace async_tcp
@@ -0,0 +1,228 @@
+/**
+ * @file SoakMonitor.cpp
+ * @brief Sampling and least-squares trend evaluation for SoakMonitor.
+ */
+
+#include "SoakMonitor.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <lwip/memp.h>
+#include <lwip/stats.h>
+#include <malloc.h>
+
+namespace async_tcp {
+
+    namespace {
+
+        constexpr float MS_PER_HOUR = 3600000.0f;
+
+        const char *metricName(const SoakMonitor::Metric m) {
+            switch (m) {
+            case SoakMonitor::Metric::HeapUsed:
+                return "heap_used";
+            case SoakMonitor::Metric::HeapPeak:
+                return "heap_peak";
+            case SoakMonitor::Metric::LargestFree:
+                return "largest_free";
+            case SoakMonitor::Metric::MempUsed:
+                return "memp_used";
+            case SoakMonitor::Metric::PbufUsed:
+                return "pbuf_used";
+            case SoakMonitor::Metric::Throughput:
+                return "bytes_per_s";
+            }
+            return "?";
+        }
+
+        constexpr SoakMonitor::Metric ALL_METRICS[] = {
+            SoakMonitor::Metric::HeapUsed,  SoakMonitor::Metric::HeapPeak,
+            SoakMonitor::Metric::LargestFree, SoakMonitor::Metric::MempUsed,
+            SoakMonitor::Metric::PbufUsed,  SoakMonitor::Metric::Throughput};
+
+    } // namespace
+
+    SoakMonitor::SoakMonitor() : SoakMonitor(Limits{}) {}
+
+    SoakMonitor::SoakMonitor(const Limits &limits) : m_limits(limits) {}
+
+    uint32_t SoakMonitor::largestFreeBlock() {
+        uint32_t lo = 0;
+        uint32_t hi = static_cast<uint32_t>(rp2040.getFreeHeap());
+        while (lo < hi) {
+            const uint32_t mid = lo + (hi - lo + 1) / 2;
+            if (void *p = malloc(mid)) {
+                free(p);
+                lo = mid;
+            } else {
+                hi = mid - 1;
+            }
+        }
+        return lo;
+    }
+
+    uint32_t SoakMonitor::mempUsed() {
+        uint32_t used = 0;
+#if LWIP_STATS && MEMP_STATS
+        for (int i = 0; i < MEMP_MAX; ++i) {
+            if (lwip_stats.memp[i]) {
+                used += lwip_stats.memp[i]->used;
+            }
+        }
+#endif
+        return used;
+    }
+
+    uint32_t SoakMonitor::pbufPoolUsed() {
+#if LWIP_STATS && MEMP_STATS
+        if (lwip_stats.memp[MEMP_PBUF_POOL]) {
+            return lwip_stats.memp[MEMP_PBUF_POOL]->used;
+        }
+#endif
+        return 0;
+    }
+
+    const SoakSample &SoakMonitor::sample(const uint64_t bytes_total) {
+        if (m_count == ASYNC_TCP_SOAK_SAMPLES) {
+            decimate();
+        }
+
+        const uint32_t now = millis();
+        uint32_t rate = 0;
+        if (m_total) {
+            // Against the previous call, which decimation may have dropped.
+            const uint32_t dt = now - m_last_t_ms;
+            if (dt) {
+                rate = static_cast<uint32_t>((bytes_total - m_last_bytes) *
+                                             1000 / dt);
+            }
+        }
+        m_last_bytes = bytes_total;
+        m_last_t_ms = now;
+
+        // The sbrk arena cannot serve as the high-water mark: the
+        // largestFreeBlock() probe itself extends it.
+        const auto used = static_cast<uint32_t>(mallinfo().uordblks);
+        m_heap_peak = std::max(m_heap_peak, used);
+        m_samples[m_count++] = {now,
+                                used,
+                                m_heap_peak,
+                                largestFreeBlock(),
+                                mempUsed(),
+                                pbufPoolUsed(),
+                                rate};
+        ++m_total;
+        return m_samples[m_count - 1];
+    }
+
+    void SoakMonitor::decimate() {
+        // Keep the first sample as the reference point, then every other
+        // one, and always the newest.
+        std::size_t out = 1;
+        for (std::size_t in = 2; in < m_count; in += 2) {
+            m_samples[out++] = m_samples[in];
+        }
+        if (m_count > 1 && (m_count - 1) % 2) {
+            m_samples[out++] = m_samples[m_count - 1];
+        }
+        m_count = out;
+    }
+
+    float SoakMonitor::value(const SoakSample &s, const Metric m) const {
+        switch (m) {
+        case Metric::HeapUsed:
+            return static_cast<float>(s.heap_used);
+        case Metric::HeapPeak:
+            return static_cast<float>(s.heap_peak);
+        case Metric::LargestFree:
+            return static_cast<float>(s.largest_free);
+        case Metric::MempUsed:
+            return static_cast<float>(s.memp_used);
+        case Metric::PbufUsed:
+            return static_cast<float>(s.pbuf_used);
+        case Metric::Throughput:
+            return static_cast<float>(s.bytes_per_s);
+        }
+        return 0.0f;
+    }
+
+    float SoakMonitor::slopePerHour(const Metric metric) const {
+        // Warm-up samples are dropped from the fit; the first throughput
+        // sample has no interval and is always skipped.
+        const std::size_t first =
+            std::max<std::size_t>(m_total > m_count ? 1 : m_limits.warmup_samples,
+                                  metric == Metric::Throughput ? 1 : 0);
+        if (m_count < first + 2) {
+            return 0.0f;
+        }
+
+        const float t0 = static_cast<float>(m_samples[first].t_ms);
+        float sx = 0, sy = 0, sxx = 0, sxy = 0;
+        const auto n = static_cast<float>(m_count - first);
+        for (std::size_t i = first; i < m_count; ++i) {
+            const float x =
+                (static_cast<float>(m_samples[i].t_ms) - t0) / MS_PER_HOUR;
+            const float y = value(m_samples[i], metric);
+            sx += x;
+            sy += y;
+            sxx += x * x;
+            sxy += x * y;
+        }
+        const float den = n * sxx - sx * sx;
+        return den > 0.0f ? (n * sxy - sx * sy) / den : 0.0f;
+    }
+
+    bool SoakMonitor::drifts(const Metric metric) const {
+        const float slope = slopePerHour(metric);
+        float mean = 0.0f;
+        for (std::size_t i = 0; i < m_count; ++i) {
+            mean += value(m_samples[i], metric);
+        }
+        mean = m_count ? mean / static_cast<float>(m_count) : 0.0f;
+        const float pct = mean > 0.0f ? slope * 100.0f / mean : 0.0f;
+
+        switch (metric) {
+        case Metric::HeapUsed:
+            return pct > m_limits.heap_growth_pct;
+        case Metric::HeapPeak:
+            return pct > m_limits.peak_growth_pct;
+        case Metric::LargestFree:
+            return -pct > m_limits.block_shrink_pct;
+        case Metric::MempUsed:
+            return slope > m_limits.memp_growth;
+        case Metric::PbufUsed:
+            return slope > m_limits.pbuf_growth;
+        case Metric::Throughput:
+            return -pct > m_limits.throughput_decay_pct;
+        }
+        return false;
+    }
+
+    bool SoakMonitor::healthy() const {
+        for (const auto m : ALL_METRICS) {
+            if (drifts(m)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void SoakMonitor::report(Print &out) const {
+        const auto &s = last();
+        out.printf("[soak] t=%lus heap=%lu peak=%lu block=%lu memp=%lu "
+                   "pbuf=%lu rate=%luB/s\n",
+                   static_cast<unsigned long>(s.t_ms / 1000),
+                   static_cast<unsigned long>(s.heap_used),
+                   static_cast<unsigned long>(s.heap_peak),
+                   static_cast<unsigned long>(s.largest_free),
+                   static_cast<unsigned long>(s.memp_used),
+                   static_cast<unsigned long>(s.pbuf_used),
+                   static_cast<unsigned long>(s.bytes_per_s));
+        for (const auto m : ALL_METRICS) {
+            out.printf("[soak]   %-12s %+.2f/h%s\n", metricName(m),
+                       static_cast<double>(slopePerHour(m)),
+                       drifts(m) ? "  DRIFT" : "");
+        }
+    }
+
+} // namespace async_tcp
@@ -0,0 +1,145 @@
+/**
+ * @file StageTimings.cpp
+ * @brief Stage bookkeeping for StageTimings.
+ */
+
+#include "StageTimings.hpp"
+
+#include <pico/time.h>
+
+namespace async_tcp {
+
+    namespace {
+
+        // 0 marks "unset" in the RX state, so never hand it out.
+        uint32_t now_us() {
+            const uint32_t t = time_us_32();
+            return t ? t : 1;
+        }
+
+    } // namespace
+
+    const char *StageTimings::name(const Stage stage) {
+        switch (stage) {
+        case Stage::RxArrivalToHandler:
+            return "rx_arrival_handler";
+        case Stage::RxHandlerToConsume:
+            return "rx_handler_consume";
+        case Stage::RxConsumeToRecved:
+            return "rx_consume_recved";
+        case Stage::RxArrivalToRecved:
+            return "rx_total";
+        case Stage::TxWriteToEnqueue:
+            return "tx_write_enqueue";
+        case Stage::TxEnqueueToOutput:
+            return "tx_enqueue_output";
+        case Stage::TxOutputToAck:
+            return "tx_output_ack";
+        case Stage::TxWriteToAck:
+            return "tx_total";
+        default:
+            return "?";
+        }
+    }
+
+    void StageTimings::record(const Stage stage, const uint32_t us) {
+        m_hist[static_cast<std::size_t>(stage)].record(us);
+    }
+
+    void StageTimings::rxArrival() {
+        if (!m_rx_arrival) {
+            m_rx_arrival = now_us();
+        }
+    }
+
+    void StageTimings::rxHandlerStart() {
+        if (m_rx_arrival && !m_rx_handler) {
+            m_rx_handler = now_us();
+            record(Stage::RxArrivalToHandler, m_rx_handler - m_rx_arrival);
+        }
+    }
+
+    void StageTimings::rxConsumed(const uint32_t t_consume,
+                                  const bool drained) {
+        if (!m_rx_arrival) {
+            return;
+        }
+        const uint32_t t_done = now_us();
+        if (m_rx_handler) {
+            record(Stage::RxHandlerToConsume, t_consume - m_rx_handler);
+        }
+        record(Stage::RxConsumeToRecved, t_done - t_consume);
+        record(Stage::RxArrivalToRecved, t_done - m_rx_arrival);
+        if (drained) {
+            m_rx_arrival = 0;
+            m_rx_handler = 0;
+        }
+    }
+
+    void StageTimings::txWritten(const uint32_t t_write,
+                                 const uint32_t t_enqueued,
+                                 const std::size_t queued) {
+        const uint32_t t_output = now_us();
+        record(Stage::TxWriteToEnqueue, t_enqueued - t_write);
+        record(Stage::TxEnqueueToOutput, t_output - t_enqueued);
+
+        m_tx_queued += static_cast<uint32_t>(queued);
+        if (m_tx_count == ASYNC_TCP_STAGE_TX_FIFO) {
+            // Still counted towards the offsets, just not timed.
+            ++m_tx_untracked;
+            return;
+        }
+        const auto tail =
+            (m_tx_head + m_tx_count) % ASYNC_TCP_STAGE_TX_FIFO;
+        m_tx_fifo[tail] = {m_tx_queued, t_write, t_output};
+        ++m_tx_count;
+    }
+
+    void StageTimings::txAcked(const uint16_t len) {
+        m_tx_acked += len;
+        const uint32_t now = now_us();
+        while (m_tx_count) {
+            const auto &w = m_tx_fifo[m_tx_head];
+            // Wrap-safe "end <= acked".
+            if (static_cast<int32_t>(m_tx_acked - w.end) < 0) {
+                break;
+            }
+            record(Stage::TxOutputToAck, now - w.t_output);
+            record(Stage::TxWriteToAck, now - w.t_write);
+            m_tx_head = (m_tx_head + 1) % ASYNC_TCP_STAGE_TX_FIFO;
+            --m_tx_count;
+        }
+    }
+
+    LatencyHistogram::Snapshot
+    StageTimings::snapshot(const Stage stage) const {
+        return m_hist[static_cast<std::size_t>(stage)].snapshot();
+    }
+
+    void StageTimings::reset() {
+        for (auto &h : m_hist) {
+            h.reset();
+        }
+        m_rx_arrival = 0;
+        m_rx_handler = 0;
+        m_tx_head = 0;
+        m_tx_count = 0;
+        m_tx_queued = 0;
+        m_tx_acked = 0;
+        m_tx_untracked = 0;
+    }
+
+    void StageTimings::print(Print &out) const {
+        for (std::size_t i = 0; i < STAGES; ++i) {
+            const auto h = snapshot(static_cast<Stage>(i));
+            out.printf("[stage] %-18s n=%lu p50=%lu p90=%lu p99=%lu max=%lu\n",
+                       name(static_cast<Stage>(i)),
+                       static_cast<unsigned long>(h.count),
+                       static_cast<unsigned long>(h.percentile(50)),
+                       static_cast<unsigned long>(h.percentile(90)),
+                       static_cast<unsigned long>(h.percentile(99)),
+                       static_cast<unsigned long>(h.max_us));
+        }
+    }
+
+} // namespace async_tcp
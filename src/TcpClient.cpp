@@ -21,7 +21,12 @@
 */
 #include "TcpClient.hpp"
 #include "async_bridge/PerpetualBridge.hpp"
+#include "AckAggregator.hpp"
+#include "AdaptiveNagle.hpp"
+#include "ScheduledWriter.hpp"
+#include "StageTimings.hpp"
 #include "TcpClientSyncAccessor.hpp"
+#include "TokenLog.hpp"
 #include <TcpClientContext.hpp>
 
 #include <LwipEthernet.h>
@@ -48,8 +53,114 @@ namespace async_tcp {
     TcpClient::TcpClient() : _ctx(nullptr) { _timeout = 5000; }
 
     TcpClient::~TcpClient() {
-        delete _ctx;
+        if (m_scheduler) {
+            m_scheduler->cancel(this);
+        }
+        if (m_scheduled_writer) {
+            m_scheduled_writer->cancel(*this);
+        }
+        if (m_ack_aggregator) {
+            m_ack_aggregator->cancel(*this);
+        }
+        _deleteContext();
+        if (m_handles) {
+            m_handles->release(getHandle());
+        }
+    }
+
+    void TcpClient::_deleteContext() {
+        if (!_ctx) {
+            return;
+        }
+        // Deliver data still queued for the receive handler while the RX
+        // buffer and the handle are valid; renewing the handle below would
+        // drop it as stale.
+        if (auto *rx_handler =
+                m_scheduled[static_cast<uint8_t>(ScheduledEvent::Received)];
+            m_scheduler && rx_handler) {
+            m_scheduler->runPending(this, rx_handler);
+            if (!_ctx) {
+                return; // the handler shut the connection down itself
+            }
+        }
+        // Fold the connection's byte counts into the client totals.
+        if (const auto rx = _ctx->getRxBuffer()) {
+            m_counters.rx_bytes += rx->receivedTotal();
+        }
+        if (const auto tx = _ctx->peekTxWriter()) {
+            m_counters.tx_bytes += tx->queuedBytes();
+            m_counters.tx_acked_bytes += tx->ackedBytes();
+        }
+        // Unpublish before retiring: lock-free readers that still hold the
+        // pointer keep it alive until they leave their guard.
+        m_shared_ctx.store(nullptr, std::memory_order_release);
+        m_state.store(CLOSED, std::memory_order_relaxed);
+        if (m_reclaimer) {
+            m_reclaimer->retire(_ctx);
+        } else {
+            delete _ctx;
+        }
         _ctx = nullptr;
+        // All four kinds: Hangup and Error must not outlive the connection.
+        if (m_readiness) {
+            m_readiness->clear(getClientId());
+        }
+        _renewHandle();
+    }
+
+    void TcpClient::setHandleTable(HandleTable *handles) {
+        if (m_handles) {
+            m_handles->release(getHandle());
+        }
+        m_handles = handles;
+        m_handle.store(handles ? handles->attach(*this) : HandleTable::INVALID,
+                       std::memory_order_release);
+    }
+
+    void TcpClient::_renewHandle() {
+        if (m_handles) {
+            m_handle.store(m_handles->renew(getHandle()),
+                           std::memory_order_release);
+        }
+    }
+
+    TcpClientLiveStats TcpClient::liveStats() const {
+        TcpClientLiveStats stats{};
+        stats.state = m_state.load(std::memory_order_relaxed);
+        if (!m_reclaimer) {
+            return stats;
+        }
+        EpochReclaimer::Guard guard(*m_reclaimer);
+        // Only the context's own members are read: the PCB may be freed by
+        // lwIP at any time, the context not before the guard is left.
+        if (const auto ctx = m_shared_ctx.load(std::memory_order_acquire)) {
+            if (const auto rx = ctx->getRxBuffer()) {
+                stats.rx_bytes = rx->receivedTotal();
+            }
+            if (const auto tx = ctx->peekTxWriter()) {
+                stats.tx_queued_bytes = tx->queuedBytes();
+                stats.tx_acked_bytes = tx->ackedBytes();
+            }
+        }
+        return stats;
+    }
+
+    void TcpClient::_updateWritable() const {
+        _setReady(ReadinessMap::Kind::Writable, _ctx && _ctx->canWriteNow());
+    }
+
+    TcpClientCounters TcpClient::getCounters() const {
+        TcpClientCounters c = m_counters;
+        if (_ctx) {
+            if (const auto rx = _ctx->getRxBuffer()) {
+                c.rx_bytes += rx->receivedTotal();
+            }
+            if (const auto tx = _ctx->peekTxWriter()) {
+                c.tx_bytes += tx->queuedBytes();
+                c.tx_acked_bytes += tx->ackedBytes();
+            }
+        }
+        return c;
     }
 
     int TcpClient::connect(const char *host, const uint16_t port) {
@@ -89,6 +200,11 @@ namespace async_tcp {
         _ctx = new TcpClientContext(pcb);
         _ctx->setClientId(getClientId());
         _ctx->setTimeout(_timeout);
+        _ctx->setStageTimings(m_stage_timings.get());
+        _ctx->setAdaptiveNagle(m_adaptive_nagle.get());
+        if (m_tx_budget) {
+            _ctx->setTxBudget(m_tx_budget, m_tx_weight);
+        }
 
         _ctx->setOnConnectCallback([this] { _onConnectCallback(); });
         _ctx->setOnErrorCallback([this](auto &&PH1) {
@@ -96,7 +212,12 @@ namespace async_tcp {
         });
         _ctx->setOnFinCallback([this] { _onFinCallback(); });
         _ctx->setOnReceivedCallback([this] { _onReceiveCallback(); });
-        _ctx->setOnPollCallback([this] { _onPollCallback(); });
+        _ctx->setOnDrainedCallback(
+            [this] { _setReady(ReadinessMap::Kind::Readable, false); });
+        // Writability is refreshed where the send buffer changes, on the
+        // networking core: after each write and on each ACK.
+        _ctx->setOnWrittenCallback([this](size_t) { _updateWritable(); });
+        _applyPollCallback();
         _ctx->setOnAckCallback(
             [this](const tcp_pcb *cb_pcb, const uint16_t len) {
                 _onAckCallback(cb_pcb, len);
@@ -111,11 +232,19 @@ namespace async_tcp {
         }
 
         setNoDelay(defaultNoDelay);
+        m_rx_posted = 0;
+        m_state.store(SYN_SENT, std::memory_order_relaxed);
+        _renewHandle();
+        m_shared_ctx.store(_ctx, std::memory_order_release);
+        if (m_readiness) {
+            m_readiness->clear(getClientId());
+        }
 
         return PICO_OK;
     }
 
     void TcpClient::setNoDelay(const bool no_delay) const {
+        m_no_delay = no_delay;
         if (!_ctx) {
             return;
         }
@@ -146,23 +275,43 @@ namespace async_tcp {
             return;
         }
 
-        // Get the TcpWriter from context (must exist if context exists)
-        const auto tx = _ctx->getTxWriter();
+        // The writer is created on first use, on the networking core; from
+        // here that takes a round trip through the sync accessor.
+        auto tx = _ctx->peekTxWriter();
+        if (!tx) {
+            assert(m_sync_accessor && "Sync accessor required for write()");
+            tx = m_sync_accessor->txWriter();
+        }
 
         assert(m_write_callback &&
                "Write callback must be configured for write operations");
         m_write_callback(tx, buf, size);
     }
 
+    bool TcpClient::writeAt(const absolute_time_t deadline,
+                            const uint8_t *buf, const std::size_t size) {
+        if (!m_scheduled_writer) {
+            return false;
+        }
+        return m_scheduled_writer->schedule(*this, deadline, buf, size);
+    }
+
     void TcpClient::setWriteCallback(WriteCallback callback) {
         m_write_callback = std::move(callback);
     }
 
-    void TcpClient::writeChunk(const uint8_t *data, const size_t size) const {
+    std::size_t TcpClient::writeChunk(const uint8_t *data,
+                                      const size_t size) const {
         if (!_ctx || !data || size == 0) {
-            return;
+            return 0;
+        }
+        return _ctx->writeChunk(data, size);
+    }
+
+    void TcpClient::stop() const {
+        if (const auto err = stop(0); err == false) {
+            DEBUGWIRE("[:i%d] :stop timeout\n", getClientId());
         }
-        _ctx->writeChunk(data, size);
     }
 
     bool TcpClient::stop(const unsigned int maxWaitMs) const {
@@ -182,10 +331,7 @@ namespace async_tcp {
         const bool ret = stop(maxWaitMs);
 
         // Clean up the context
-        if (_ctx) {
-            delete _ctx;
-            _ctx = nullptr;
-        }
+        _deleteContext();
 
         return ret;
     }
@@ -197,6 +343,10 @@ namespace async_tcp {
      */
     uint8_t TcpClient::status() { return m_sync_accessor->status(); }
 
+    TcpWriter *TcpClient::_ts_txWriter() const {
+        return _ctx ? _ctx->getTxWriter() : nullptr;
+    }
+
     uint8_t TcpClient::_ts_status() {
         if (!_ctx) {
             return CLOSED;
@@ -315,11 +465,20 @@ namespace async_tcp {
     }
 
     void TcpClient::_onConnectCallback() const {
+        ++m_counters.connects;
+        m_state.store(ESTABLISHED, std::memory_order_relaxed);
+        m_poll_acked = 0;
+        _updateWritable();
+        _post(Completion::Type::Connected, ERR_OK);
         const AIPAddress remote_ip = remoteIP();
         (void)remote_ip;
+        // The address is logged as a word so tokenized logging accepts it.
         DEBUGWIRE("[TcpClient][%d] TcpClient::_onConnectCallback(): Connected "
-                  "to %s.\n",
-                  getClientId(), remote_ip.toString().c_str());
+                  "to %08x.\n",
+                  getClientId(), static_cast<uint32_t>(remote_ip));
+        if (_schedule(ScheduledEvent::Connected, ERR_OK)) {
+            return;
+        }
         if (_connected_callback_bridge) {
             _connected_callback_bridge->run();
         } else {
@@ -330,6 +489,10 @@ namespace async_tcp {
     }
 
     void TcpClient::_onFinCallback() const {
+        ++m_counters.fins;
+        m_state.store(CLOSE_WAIT, std::memory_order_relaxed);
+        _setReady(ReadinessMap::Kind::Hangup, true);
+        _post(Completion::Type::Fin, 0);
         DEBUGWIRE(
             "[TcpClient][%d] TcpClient::_onFinCallback(): FIN received.\n",
             getClientId());
@@ -337,13 +500,16 @@ namespace async_tcp {
         // Get TcpWriter from context and notify about connection closure
         if (_ctx) {
             // ReSharper disable once CppDFAConstantConditions
-            if (const auto tx = _ctx->getTxWriter()) {
+            if (const auto tx = _ctx->peekTxWriter()) {
                 // ReSharper disable once CppDFAUnreachableCode
                 tx->onError(
                     ERR_CLSD); // Always notify the Writer class on close.
             }
         }
 
+        if (_schedule(ScheduledEvent::Fin, 0)) {
+            return;
+        }
         if (_fin_callback_bridge) {
             // ReSharper disable once CppDFANullDereference
             _fin_callback_bridge->workload(_ctx->getRxBuffer());
@@ -358,6 +524,18 @@ namespace async_tcp {
     void TcpClient::_onErrorCallback(const err_t err) const {
         DEBUGWIRE("[TcpClient][%d] The ctx failed with the error code: %d",
                   getClientId(), err);
+        ++m_counters.errors;
+        // Only lwIP's tcp_err ends the connection; a failed write leaves it
+        // open.
+        if (_ctx && _ctx->failed()) {
+            m_state.store(CLOSED, std::memory_order_relaxed);
+            _setReady(ReadinessMap::Kind::Writable, false);
+        }
+        _setReady(ReadinessMap::Kind::Error, true);
+        _post(Completion::Type::Error, err);
+        if (_schedule(ScheduledEvent::Error, err)) {
+            return;
+        }
 
         // Dispatch error handling via PerpetualBridge if provided
         if (_error_callback_bridge) {
@@ -370,6 +548,16 @@ namespace async_tcp {
     }
 
     void TcpClient::_onReceiveCallback() const {
+        _setReady(ReadinessMap::Kind::Readable, true);
+        if (m_completions) {
+            const auto total = _ctx->getRxBuffer()->receivedTotal();
+            _post(Completion::Type::Readable,
+                  static_cast<int32_t>(total - m_rx_posted));
+            m_rx_posted = total;
+        }
+        if (_schedule(ScheduledEvent::Received, 0)) {
+            return;
+        }
         if (_received_callback_bridge) {
             _received_callback_bridge->workload(_ctx->getRxBuffer());
             _received_callback_bridge->run();
@@ -381,8 +569,21 @@ namespace async_tcp {
     }
 
     void TcpClient::_onAckCallback(const struct tcp_pcb *tpcb,
-                                   const uint16_t len) const {
+                                   const uint16_t len) {
         (void)tpcb; // PCB parameter not needed
+        _updateWritable();
+        _post(Completion::Type::WriteAcked, len);
+        if (m_ack_aggregator) {
+            m_ack_aggregator->add(*this, len);
+        } else {
+            _dispatchAck(len);
+        }
+    }
+
+    void TcpClient::_dispatchAck(const uint16_t len) const {
+        if (_schedule(ScheduledEvent::Ack, len)) {
+            return;
+        }
 
         // Dispatch ACK handling bridge (if any) with len payload
         if (_ack_callback_bridge) {
@@ -392,12 +593,42 @@ namespace async_tcp {
         }
     }
 
+    void TcpClient::setAckAggregator(AckAggregator *aggregator) {
+        if (m_ack_aggregator) {
+            // Hand over what the old aggregator still holds.
+            m_ack_aggregator->cancel(*this);
+            if (const auto bytes = takeAckedBytes()) {
+                _dispatchAck(static_cast<uint16_t>(bytes));
+            }
+        }
+        m_ack_aggregator = aggregator;
+    }
+
     void TcpClient::setOnErrorCallback(PerpetualBridgePtr bridge) {
         _error_callback_bridge = std::move(bridge);
     }
 
     void TcpClient::setOnPollCallback(PerpetualBridgePtr bridge) {
         _poll_callback_bridge = std::move(bridge);
+        if (_ctx) {
+            _applyPollCallback();
+        }
+    }
+
+    void TcpClient::_applyPollCallback() const {
+        // tcp_poll runs every tick only for clients that consume it: a poll
+        // bridge or handler, or a readiness map refreshed from the poll.
+        // Otherwise a slow poll keeps the polls/stalls counters going.
+        if (_poll_callback_bridge ||
+            m_scheduled[static_cast<uint8_t>(ScheduledEvent::Poll)] ||
+            m_readiness) {
+            _ctx->setOnPollCallback([this] { _onPollCallback(); });
+        } else if (ASYNC_TCP_STALL_POLL) {
+            _ctx->setOnPollCallback([this] { _onPollCallback(); },
+                                    ASYNC_TCP_STALL_POLL);
+        } else {
+            _ctx->setOnPollCallback(nullptr);
+        }
     }
 
     void TcpClient::setOnAckCallback(PerpetualBridgePtr bridge) {
@@ -410,7 +641,77 @@ namespace async_tcp {
         m_sync_accessor = std::move(accessor);
     }
 
+    void TcpClient::enableStageTimings(const bool enable) {
+        if (enable && !m_stage_timings) {
+            m_stage_timings = make_unique<StageTimings>();
+        } else if (!enable && m_stage_timings) {
+            // Detach before freeing: the RX/TX hooks hold the raw pointer.
+            if (_ctx) {
+                _ctx->setStageTimings(nullptr);
+            }
+            m_stage_timings.reset();
+            return;
+        }
+        if (_ctx) {
+            _ctx->setStageTimings(m_stage_timings.get());
+        }
+    }
+
+    bool TcpClient::_schedule(const ScheduledEvent event,
+                              const int32_t value) const {
+        auto *handler = m_scheduled[static_cast<uint8_t>(event)];
+        if (!m_scheduler || !handler) {
+            return false;
+        }
+        // Connection state changes are never coalesced and always jump the
+        // data queues.
+        const bool critical = event == ScheduledEvent::Connected ||
+                              event == ScheduledEvent::Fin ||
+                              event == ScheduledEvent::Error;
+        const auto priority =
+            critical ? PriorityScheduler::Priority::Critical : m_data_priority;
+        // Data queued before a FIN or error must still be handled before
+        // it: move it ahead into Critical first.
+        if ((event == ScheduledEvent::Fin || event == ScheduledEvent::Error) &&
+            !m_scheduler->promote(this)) {
+            return false;
+        }
+        // A full queue falls back to the bridge rather than losing the event.
+        return m_scheduler->post(priority, handler,
+                                 const_cast<TcpClient *>(this), value,
+                                 !critical, getHandle());
+    }
+
+    void TcpClient::enableAdaptiveNoDelay(const bool enable) {
+        if (enable && !m_adaptive_nagle) {
+            m_adaptive_nagle = make_unique<AdaptiveNagle>();
+        } else if (!enable && m_adaptive_nagle) {
+            if (_ctx) {
+                _ctx->setAdaptiveNagle(nullptr);
+            }
+            m_adaptive_nagle.reset();
+            setNoDelay(m_no_delay);
+            return;
+        }
+        if (_ctx) {
+            _ctx->setAdaptiveNagle(m_adaptive_nagle.get());
+        }
+    }
+
     void TcpClient::_onPollCallback() const {
+        ++m_counters.polls;
+        if (const auto tx = _ctx ? _ctx->peekTxWriter() : nullptr) {
+            const auto acked = tx->ackedBytes();
+            if (tx->queuedBytes() != acked && acked == m_poll_acked) {
+                ++m_counters.stalls;
+            }
+            m_poll_acked = acked;
+        }
+        _updateWritable();
+        if (_schedule(ScheduledEvent::Poll, 0)) {
+            return;
+        }
+
         if (_poll_callback_bridge) {
             _poll_callback_bridge->run();
         } // else: no-op when no handler is registered
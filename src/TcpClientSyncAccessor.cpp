@@ -3,7 +3,7 @@
 //
 #include "TcpClientSyncAccessor.hpp"
 #include "TcpClient.hpp"
-#include "debug_internal.h"
+#include "TokenLog.hpp"
 
 // Next optional refinements (if you want to pursue them later):
 // Introduce a small struct Result<size_t> { int status; size_t value; } to avoid ambiguity.
@@ -26,6 +26,12 @@ namespace async_tcp {
                 return PICO_OK;
             }
             return PICO_ERROR_NO_DATA;
+        case AccessorPayload::TX_WRITER:
+            if (p->writer_ptr) {
+                *p->writer_ptr = m_io._ts_txWriter();
+                return PICO_OK;
+            }
+            return PICO_ERROR_NO_DATA;
         default:
             return PICO_ERROR_INVALID_ARG;
         }
@@ -85,4 +91,27 @@ namespace async_tcp {
         return result;
     }
 
+    TcpWriter *TcpClientSyncAccessor::txWriter() {
+        // Same-core: take the async context lock and create it directly
+        if (!isCrossCore()) {
+            ctxLock();
+            TcpWriter *tx = m_io._ts_txWriter();
+            ctxUnlock();
+            return tx;
+        }
+
+        // Cross-core: execute via bridge to run in the networking context
+        TcpWriter *tx = nullptr;
+        auto payload = std::make_unique<AccessorPayload>();
+        payload->op = AccessorPayload::TX_WRITER;
+        payload->writer_ptr = &tx;
+
+        if (const auto res = execute(std::move(payload)); res != PICO_OK) {
+            DEBUGCORE("[ERROR] TcpClientSyncAccessor::txWriter() returned "
+                      "error %d.\n",
+                      res);
+        }
+        return tx;
+    }
+
 } // namespace async_tcp
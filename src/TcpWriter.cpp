@@ -9,8 +9,11 @@
 
 #include "TcpWriter.hpp"
 
+#include "AdaptiveNagle.hpp"
+#include "StageTimings.hpp"
 #include "TcpClient.hpp"
 #include "TcpClientContext.hpp"
+#include "TokenLog.hpp"
 #include <cstring>
 
 namespace async_tcp {
@@ -18,7 +21,9 @@ namespace async_tcp {
     // --- Pure C bridge ---
     err_t lwip_sent_cb(void *arg, tcp_pcb *tpcb,
                        u16_t len) { // NOLINT len canot be constant
-        auto *tx = static_cast<TcpClientContext *>(arg)->getTxWriter();
+        const auto *ctx = static_cast<TcpClientContext *>(arg);
+        ASYNC_TCP_RECORD(Sent, ctx->getClientId(), len);
+        auto *tx = ctx->peekTxWriter();
         assert(tx && "IoTxWriter must exist when ACK callback is invoked - "
                      "setup error!");
         // ReSharper disable once CppDFAUnreachableCode
@@ -29,21 +34,63 @@ namespace async_tcp {
     TcpWriter::TcpWriter(tcp_pcb *pcb) : m_pcb(pcb) {}
 
     std::size_t TcpWriter::availableForWrite() const {
-        return m_pcb ? tcp_sndbuf(m_pcb) : 0;
+        if (!m_pcb) {
+            return 0;
+        }
+        const std::size_t sndbuf = tcp_sndbuf(m_pcb);
+        return m_budget_account
+                   ? std::min(sndbuf, m_budget->allowance(*m_budget_account))
+                   : sndbuf;
+    }
+
+    void TcpWriter::noteQueued(const std::size_t bytes) {
+        m_queued += bytes;
+        if (m_budget_account) {
+            m_budget->charge(*m_budget_account, bytes);
+        }
+    }
+
+    void TcpWriter::setTxBudget(TxBudget *budget, const uint8_t weight) {
+        if (m_budget_account) {
+            m_budget->close(m_budget_account);
+        }
+        m_budget = budget;
+        m_budget_account = budget ? budget->open(weight) : nullptr;
+        if (!m_budget_account) {
+            m_budget = nullptr;
+        }
+    }
+
+    void TcpWriter::observeWrite(const std::size_t size, const uint32_t t_us) {
+        if (!m_nagle || !m_pcb) {
+            return;
+        }
+        if (m_nagle->observe(size, t_us)) {
+            tcp_nagle_enable(m_pcb);
+        } else {
+            tcp_nagle_disable(m_pcb);
+        }
     }
 
     std::size_t TcpWriter::writeData(const uint8_t *data,
-                                     const std::size_t size) {
+                                     const std::size_t size,
+                                     const bool copy) {
         if (!m_pcb || !data || size == 0) {
             return 0; // nothing to do / invalid state
         }
 
+        const uint32_t t_write = m_timings || m_nagle ? time_us_32() : 0;
+        observeWrite(size, t_write);
         std::size_t total_queued = 0;
+        std::size_t enqueued = 0; // survives the error paths below
 
         while (total_queued < size) {
             const std::size_t remaining = size - total_queued;
             const std::size_t chunk_size = getOptimalChunkSize(remaining);
             if (chunk_size == 0) {
+                if (m_budget_account && m_pcb && tcp_sndbuf(m_pcb)) {
+                    ++m_budget_account->throttled; // over share: wait for ACKs
+                }
                 DEBUGWIRE(
                     "[TcpWriter] Send buffer full (queued=%zu) - rejected\n",
                     total_queued);
@@ -53,8 +100,11 @@ namespace async_tcp {
 
             // Set TCP_WRITE_FLAG_MORE only if we know we will write more
             // afterwards.
-            const u8_t flags =
+            u8_t flags =
                 (total_queued + chunk_size < size) ? TCP_WRITE_FLAG_MORE : 0;
+            if (copy) {
+                flags |= TCP_WRITE_FLAG_COPY;
+            }
 
             const err_t err =
                 tcp_write(m_pcb, data + total_queued, chunk_size, flags);
@@ -66,17 +116,40 @@ namespace async_tcp {
             }
 
             total_queued += chunk_size;
+            enqueued += chunk_size;
         }
 
-        // Flush immediately – Nagle is disabled, so this forces the packet out.
-        if (total_queued > 0) {
+        const uint32_t t_enqueued = m_timings ? time_us_32() : 0;
+
+        // Flush immediately – with Nagle disabled this forces the packet out;
+        // with adaptive coalescing on, lwIP holds small segments back.
+        // Bytes already queued before an error still go out and get ACKed.
+        if (enqueued > 0) {
             tcp_output(m_pcb);
+            noteQueued(enqueued);
+            if (m_timings) {
+                m_timings->txWritten(t_write, t_enqueued, enqueued);
+            }
+        }
+        if (m_written_cb) {
+            m_written_cb(total_queued);
         }
 
         return total_queued;
     }
 
-    void TcpWriter::onAckCallback(tcp_pcb *pcb, uint16_t len) { /* no-op */ }
+    void TcpWriter::onAckCallback(tcp_pcb *pcb, const uint16_t len) {
+        m_acked += len;
+        if (m_budget_account) {
+            m_budget->release(*m_budget_account, len);
+        }
+        if (m_timings) {
+            m_timings->txAcked(len);
+        }
+        if (m_ack_cb) {
+            m_ack_cb(pcb, len);
+        }
+    }
 
     void TcpWriter::onError(const err_t error) {
         DEBUGWIRE("[TcpWriter] Error %d -> reset\n", error);
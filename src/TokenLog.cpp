@@ -0,0 +1,94 @@
+/**
+ * @file TokenLog.cpp
+ * @brief Per-core word rings backing the tokenized logging backend.
+ */
+
+#include "TokenLog.hpp"
+
+#include <Arduino.h>
+#include <atomic>
+#include <hardware/sync.h>
+#include <pico/time.h>
+
+namespace async_tcp {
+
+    namespace {
+
+        constexpr std::uint32_t RING_MASK = ASYNC_TCP_TLOG_RING_WORDS - 1;
+
+        /**
+         * @brief Single-producer (owning core) / single-consumer ring.
+         *
+         * head and tail are free-running word counters; the writer publishes
+         * a complete record by advancing head after all words are stored.
+         */
+        struct TokenRing {
+                std::uint32_t words[ASYNC_TCP_TLOG_RING_WORDS]{};
+                std::atomic<std::uint32_t> head{0};
+                std::atomic<std::uint32_t> tail{0};
+                std::uint32_t sequence = 0;
+                std::atomic<std::uint32_t> dropped{0};
+        };
+
+        TokenRing s_rings[NUM_CORES];
+
+    } // namespace
+
+    void TokenLog::append(const std::uint32_t token, const std::uint32_t *args,
+                          const std::size_t argc) {
+        const auto need = static_cast<std::uint32_t>(3 + argc);
+        const auto core = get_core_num();
+        auto &ring = s_rings[core];
+
+        // Masking IRQs keeps a handler on this core from interleaving its own
+        // record with ours; the other core writes to its own ring.
+        const auto irq = save_and_disable_interrupts();
+        const auto head = ring.head.load(std::memory_order_relaxed);
+        const auto tail = ring.tail.load(std::memory_order_acquire);
+        if (ASYNC_TCP_TLOG_RING_WORDS - (head - tail) < need) {
+            ring.dropped.store(ring.dropped.load(std::memory_order_relaxed) + 1,
+                               std::memory_order_relaxed);
+            restore_interrupts(irq);
+            return;
+        }
+
+        auto pos = head;
+        ring.words[pos++ & RING_MASK] = MAGIC << 24 |
+                                        static_cast<std::uint32_t>(argc) << 16 |
+                                        core << 12 | (ring.sequence++ & 0xFFF);
+        ring.words[pos++ & RING_MASK] = token;
+        ring.words[pos++ & RING_MASK] = time_us_32();
+        for (std::size_t i = 0; i < argc; ++i) {
+            ring.words[pos++ & RING_MASK] = args[i];
+        }
+        ring.head.store(pos, std::memory_order_release);
+        restore_interrupts(irq);
+    }
+
+    std::size_t TokenLog::dump(Print &out) {
+        std::size_t written = 0;
+        for (auto &ring : s_rings) {
+            const auto head = ring.head.load(std::memory_order_acquire);
+            auto tail = ring.tail.load(std::memory_order_relaxed);
+            while (tail != head) {
+                const std::uint32_t w = ring.words[tail++ & RING_MASK];
+                const uint8_t bytes[4] = {
+                    static_cast<uint8_t>(w), static_cast<uint8_t>(w >> 8),
+                    static_cast<uint8_t>(w >> 16),
+                    static_cast<uint8_t>(w >> 24)};
+                written += out.write(bytes, sizeof(bytes));
+            }
+            ring.tail.store(tail, std::memory_order_release);
+        }
+        return written;
+    }
+
+    std::uint32_t TokenLog::dropped() {
+        std::uint32_t total = 0;
+        for (const auto &ring : s_rings) {
+            total += ring.dropped.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+} // namespace async_tcp
@@ -0,0 +1,73 @@
+/**
+ * @file TxBudget.cpp
+ * @brief Weighted fair shares for TxBudget.
+ */
+
+#include "TxBudget.hpp"
+
+#include <algorithm>
+
+namespace async_tcp {
+
+    TxBudget::TxBudget(const std::size_t total, const std::size_t minimum)
+        : m_total(total), m_minimum(std::min(minimum, total)) {}
+
+    TxBudget::Account *TxBudget::open(const uint8_t weight) {
+        for (auto &a : m_accounts) {
+            if (!a.weight) {
+                a = Account{};
+                a.weight = weight ? weight : 1;
+                m_weights += a.weight;
+                ++m_open;
+                return &a;
+            }
+        }
+        return nullptr;
+    }
+
+    void TxBudget::close(Account *account) {
+        if (!account || !account->weight) {
+            return;
+        }
+        m_used -= account->in_flight;
+        m_weights -= account->weight;
+        --m_open;
+        *account = Account{};
+    }
+
+    std::size_t TxBudget::share(const Account &account) const {
+        const std::size_t reserved = m_minimum * m_open;
+        const std::size_t spare = m_total > reserved ? m_total - reserved : 0;
+        return m_minimum +
+               static_cast<std::size_t>(static_cast<uint64_t>(spare) *
+                                        account.weight / m_weights);
+    }
+
+    std::size_t TxBudget::allowance(const Account &account) const {
+        // Keep the unused part of every other account's guarantee free.
+        std::size_t reserved = 0;
+        for (const auto &a : m_accounts) {
+            if (a.weight && &a != &account && a.in_flight < m_minimum) {
+                reserved += m_minimum - a.in_flight;
+            }
+        }
+        const std::size_t committed = m_used + reserved;
+        const std::size_t free = m_total > committed ? m_total - committed : 0;
+        const std::size_t own = share(account);
+        return std::min(free,
+                        own > account.in_flight ? own - account.in_flight : 0);
+    }
+
+    void TxBudget::charge(Account &account, const std::size_t bytes) {
+        account.in_flight += bytes;
+        account.peak = std::max(account.peak, account.in_flight);
+        m_used += bytes;
+    }
+
+    void TxBudget::release(Account &account, const std::size_t bytes) {
+        const std::size_t n = std::min(bytes, account.in_flight);
+        account.in_flight -= n;
+        m_used -= n;
+    }
+
+} // namespace async_tcp
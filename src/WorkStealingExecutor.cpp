@@ -0,0 +1,179 @@
+/**
+ * @file WorkStealingExecutor.cpp
+ * @brief Deque operations, stealing and utilization accounting.
+ */
+
+#include "WorkStealingExecutor.hpp"
+
+#include <pico/platform.h>
+#include <pico/time.h>
+
+namespace async_tcp {
+
+    WorkStealingExecutor::WorkStealingExecutor(const uint8_t networking_core)
+        : m_networking_core(networking_core) {
+        const uint32_t now = time_us_32();
+        for (auto &c : m_cores) {
+            c.stealable.lock =
+                spin_lock_instance(spin_lock_claim_unused(true));
+            c.pinned.lock = spin_lock_instance(spin_lock_claim_unused(true));
+            c.window_start_us = now;
+        }
+        m_networking.lock = spin_lock_instance(spin_lock_claim_unused(true));
+    }
+
+    WorkStealingExecutor::~WorkStealingExecutor() {
+        for (auto &c : m_cores) {
+            release(c.stealable);
+            release(c.pinned);
+        }
+        release(m_networking);
+    }
+
+    void WorkStealingExecutor::release(Deque &d) {
+        spin_lock_unclaim(spin_lock_get_num(d.lock));
+        d.lock = nullptr;
+    }
+
+    bool WorkStealingExecutor::push(Deque &d, const Task task) {
+        const uint32_t save = spin_lock_blocking(d.lock);
+        const bool ok = d.bottom - d.top < DEQUE_SIZE;
+        if (ok) {
+            d.tasks[d.bottom++ & (DEQUE_SIZE - 1)] = task;
+        }
+        spin_unlock(d.lock, save);
+        return ok;
+    }
+
+    bool WorkStealingExecutor::popBottom(Deque &d, Task &task) {
+        const uint32_t save = spin_lock_blocking(d.lock);
+        const bool ok = d.bottom != d.top;
+        if (ok) {
+            task = d.tasks[--d.bottom & (DEQUE_SIZE - 1)];
+        }
+        spin_unlock(d.lock, save);
+        return ok;
+    }
+
+    bool WorkStealingExecutor::popTop(Deque &d, Task &task) {
+        const uint32_t save = spin_lock_blocking(d.lock);
+        const bool ok = d.bottom != d.top;
+        if (ok) {
+            task = d.tasks[d.top++ & (DEQUE_SIZE - 1)];
+        }
+        spin_unlock(d.lock, save);
+        return ok;
+    }
+
+    bool WorkStealingExecutor::submit(const TaskFn fn, void *arg,
+                                      const Affinity affinity) {
+        if (!fn) {
+            return false;
+        }
+        const uint8_t here = get_core_num();
+        Deque *target = nullptr;
+        uint8_t owner = here;
+        switch (affinity) {
+        case Affinity::Any:
+            target = &m_cores[here].stealable;
+            break;
+        case Affinity::Networking:
+            owner = m_networking_core;
+            if (!m_networking_ctx) {
+                ++m_cores[owner].stats.rejected;
+                return false;
+            }
+            target = &m_networking;
+            break;
+        case Affinity::Core0:
+            owner = 0;
+            target = &m_cores[0].pinned;
+            break;
+        case Affinity::Core1:
+            owner = 1;
+            target = &m_cores[1].pinned;
+            break;
+        }
+        if (!push(*target, {fn, arg})) {
+            ++m_cores[owner].stats.rejected;
+            return false;
+        }
+        __sev(); // wake a core idling in __wfe()
+        return true;
+    }
+
+    void WorkStealingExecutor::execute(PerCore &self, const Task task,
+                                       const bool stolen) {
+        const uint32_t start = time_us_32();
+        task.fn(task.arg);
+        self.stats.busy_us += time_us_32() - start;
+        ++self.stats.executed;
+        if (stolen) {
+            ++self.stats.stolen;
+        }
+    }
+
+    bool WorkStealingExecutor::runOnce() {
+        const uint8_t here = get_core_num();
+        PerCore &self = m_cores[here];
+        Task task{};
+
+        if (here == m_networking_core && popBottom(m_networking, task)) {
+            async_context_acquire_lock_blocking(m_networking_ctx);
+            execute(self, task, false);
+            async_context_release_lock(m_networking_ctx);
+            return true;
+        }
+        if (popBottom(self.pinned, task) ||
+            popBottom(self.stealable, task)) {
+            execute(self, task, false);
+            return true;
+        }
+        // Idle: take the oldest task of the other core, the one it would
+        // reach last.
+        if (popTop(m_cores[here ^ 1].stealable, task)) {
+            execute(self, task, true);
+            return true;
+        }
+        return false;
+    }
+
+    std::size_t WorkStealingExecutor::run(const uint32_t budget_us) {
+        const uint32_t start = time_us_32();
+        std::size_t n = 0;
+        while (time_us_32() - start < budget_us && runOnce()) {
+            ++n;
+        }
+        return n;
+    }
+
+    WorkStealingExecutor::Stats
+    WorkStealingExecutor::stats(const uint8_t core) const {
+        Stats s = m_cores[core].stats;
+        s.window_us = time_us_32() - m_cores[core].window_start_us;
+        return s;
+    }
+
+    void WorkStealingExecutor::resetStats() {
+        const uint32_t now = time_us_32();
+        for (auto &c : m_cores) {
+            // Counters are only approximate while tasks run on the other
+            // core; this is for reporting, not accounting.
+            c.stats = {};
+            c.window_start_us = now;
+        }
+    }
+
+    void WorkStealingExecutor::print(Print &out) const {
+        for (uint8_t core = 0; core < NUM_CORES; ++core) {
+            const auto s = stats(core);
+            out.printf("[exec] core%u tasks=%lu stolen=%lu rejected=%lu "
+                       "util=%.1f%%\n",
+                       core, static_cast<unsigned long>(s.executed),
+                       static_cast<unsigned long>(s.stolen),
+                       static_cast<unsigned long>(s.rejected),
+                       static_cast<double>(s.utilization() * 100.0f));
+        }
+    }
+
+} // namespace async_tcp
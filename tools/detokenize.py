@@ -0,0 +1,137 @@
+#!/usr/bin/env python3
+"""Decode a tokenized async-tcp log stream (see include/TokenLog.hpp).
+
+The token dictionary is rebuilt from the sources: every DEBUGWIRE(...) and
+DEBUGCORE(...) format literal is hashed with FNV-1a, exactly as the firmware
+does at compile time.
+
+Usage:
+    detokenize.py [--src DIR ...] capture.bin
+    detokenize.py [--src DIR ...] --dict        # list tokens and formats
+"""
+
+import argparse
+import pathlib
+import re
+import struct
+import sys
+
+MAGIC = 0xA5
+MACROS = ("DEBUGWIRE", "DEBUGCORE", "ASYNC_TCP_TLOG")
+SOURCE_SUFFIXES = {".c", ".cc", ".cpp", ".h", ".hpp", ".ino"}
+
+CALL_RE = re.compile(r"\b(?:%s)\s*\(\s*((?:\"(?:[^\"\\]|\\.)*\"\s*)+)" %
+                     "|".join(MACROS), re.S)
+LITERAL_RE = re.compile(r"\"((?:[^\"\\]|\\.)*)\"", re.S)
+SPEC_RE = re.compile(r"%[-+ #0]*\d*(?:\.\d+)?(hh|h|ll|l|z|j|t)?([diouxXcspfFeEgG%])")
+
+
+def fnv1a(data: bytes) -> int:
+    h = 2166136261
+    for b in data:
+        h ^= b
+        h = (h * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def unescape(literal: str) -> bytes:
+    return literal.encode("latin-1").decode("unicode_escape").encode("latin-1")
+
+
+def build_dictionary(roots):
+    tokens = {}
+    for root in roots:
+        for path in pathlib.Path(root).rglob("*"):
+            if path.suffix not in SOURCE_SUFFIXES or not path.is_file():
+                continue
+            text = path.read_text(encoding="utf-8", errors="replace")
+            for call in CALL_RE.finditer(text):
+                fmt = b"".join(unescape(m.group(1))
+                               for m in LITERAL_RE.finditer(call.group(1)))
+                line = text.count("\n", 0, call.start()) + 1
+                tokens.setdefault(fnv1a(fmt), (fmt.decode("latin-1"),
+                                               "%s:%d" % (path, line)))
+    return tokens
+
+
+def render(fmt: str, args):
+    out, argi = [], 0
+
+    def take():
+        nonlocal argi
+        value = args[argi] if argi < len(args) else 0
+        argi += 1
+        return value
+
+    pos = 0
+    for spec in SPEC_RE.finditer(fmt):
+        out.append(fmt[pos:spec.start()])
+        pos = spec.end()
+        conv = spec.group(2)
+        if conv == "%":
+            out.append("%")
+            continue
+        word = take()
+        if conv in "di":
+            word = struct.unpack("<i", struct.pack("<I", word))[0]
+            out.append(str(word))
+        elif conv == "s":
+            out.append("<str@0x%08x>" % word)
+        elif conv == "p":
+            out.append("0x%08x" % word)
+        elif conv in "fFeEgG":
+            out.append(spec.group(0) % struct.unpack("<f", struct.pack("<I", word))[0])
+        else:
+            out.append(spec.group(0).replace(spec.group(1) or "", "") % word)
+    out.append(fmt[pos:])
+    return "".join(out)
+
+
+def decode(stream: bytes, tokens):
+    words = struct.unpack("<%dI" % (len(stream) // 4), stream[:len(stream) // 4 * 4])
+    i = 0
+    while i + 3 <= len(words):
+        header = words[i]
+        if header >> 24 != MAGIC:
+            i += 1  # resynchronise on the next header
+            continue
+        argc = (header >> 16) & 0xFF
+        core = (header >> 12) & 0xF
+        seq = header & 0xFFF
+        token, stamp = words[i + 1], words[i + 2]
+        args = words[i + 3:i + 3 + argc]
+        i += 3 + argc
+        fmt, _ = tokens.get(token, (None, None))
+        text = render(fmt, args) if fmt is not None else \
+            "<unknown token 0x%08x> %s" % (token, " ".join("0x%08x" % a for a in args))
+        yield "%10u c%d #%03x %s" % (stamp, core, seq, text.rstrip("\n"))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--src", action="append", default=[],
+                        help="source directory to scan (repeatable)")
+    parser.add_argument("--dict", action="store_true", help="print the token dictionary")
+    parser.add_argument("capture", nargs="?", help="binary dump from TokenLog::dump()")
+    opts = parser.parse_args()
+
+    repo = pathlib.Path(__file__).resolve().parent.parent
+    roots = opts.src or [repo / "src", repo / "include", repo / "examples"]
+    tokens = build_dictionary(roots)
+
+    if opts.dict:
+        for token, (fmt, where) in sorted(tokens.items()):
+            print("0x%08x %-40s %r" % (token, where, fmt))
+        return 0
+    if not opts.capture:
+        parser.error("capture file required")
+
+    data = pathlib.Path(opts.capture).read_bytes()
+    for line in decode(data, tokens):
+        print(line)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,226 @@
+#!/usr/bin/env python3
+"""Sweep lwIP options and pick Pareto-optimal configurations.
+
+Builds and runs examples/lwip_sweep_bench.cpp once per point of a matrix of
+TCP_MSS, TCP_WND, TCP_SND_BUF, PBUF_POOL_SIZE and MEMP_NUM_TCP_SEG values,
+collects its SWEEP lines and prints a table of throughput, latency and memory
+per configuration, marking the Pareto front (higher rx/tx throughput, lower
+echo p99 latency, lower memory).
+
+The build and run steps are user-supplied command templates, since they
+depend on the toolchain and on how the board is flashed and read. Templates
+are formatted with:
+
+    {defines}  -DTCP_MSS=1460 -DTCP_WND=... (space separated)
+    {header}   path of a generated lwipopts override header
+    {tag}      short configuration name, e.g. mss1460-wnd5840-...
+
+The run command must print the bench's serial output (the SWEEP lines) on
+stdout and exit, e.g. flash, then read the port until "SWEEP done".
+
+Usage:
+    lwip_sweep.py --build 'arduino-cli compile ... {defines}' \\
+                  --run 'tools/flash_and_read.sh {tag}' \\
+                  [--mss 536,1460] [--wnd-mss 2,4,8] [--snd-buf-mss 2,4,8] \\
+                  [--pbuf-pool 8,16,24] [--tcp-seg 16,32] [--budget BYTES]
+    lwip_sweep.py --parse results/*.log      # table from saved outputs
+"""
+
+import argparse
+import itertools
+import pathlib
+import re
+import subprocess
+import sys
+import tempfile
+
+SWEEP_RE = re.compile(r"^SWEEP (workload=.*)$")
+OPTIONS = ("mss", "wnd", "snd_buf", "pbuf_pool", "tcp_seg")
+
+
+def int_list(text):
+    return [int(v) for v in text.split(",") if v]
+
+
+def matrix(args):
+    """Yield option dicts, skipping combinations lwIP rejects at build time."""
+    for mss, wnd_k, buf_k, pool, seg in itertools.product(
+            args.mss, args.wnd_mss, args.snd_buf_mss, args.pbuf_pool,
+            args.tcp_seg):
+        wnd, snd_buf = mss * wnd_k, mss * buf_k
+        # lwIP's init.c sanity checks: default TCP_SND_QUEUELEN and its
+        # relation to MEMP_NUM_TCP_SEG, and a window below 0xffff without
+        # window scaling.
+        queuelen = (4 * snd_buf + mss - 1) // mss
+        if seg < queuelen or snd_buf < 2 * mss or wnd > 0xFFFF:
+            continue
+        yield {"mss": mss, "wnd": wnd, "snd_buf": snd_buf,
+               "pbuf_pool": pool, "tcp_seg": seg}
+
+
+def tag(opts):
+    return "-".join("%s%d" % (k.replace("_", ""), opts[k]) for k in OPTIONS)
+
+
+def defines(opts):
+    return {"TCP_MSS": opts["mss"], "TCP_WND": opts["wnd"],
+            "TCP_SND_BUF": opts["snd_buf"],
+            "PBUF_POOL_SIZE": opts["pbuf_pool"],
+            "MEMP_NUM_TCP_SEG": opts["tcp_seg"],
+            "LWIP_STATS": 1, "MEMP_STATS": 1}
+
+
+def write_header(opts, directory):
+    path = pathlib.Path(directory) / ("lwipopts_%s.h" % tag(opts))
+    lines = ["// Generated by lwip_sweep.py; include after lwipopts.h.",
+             "#pragma once"]
+    for name, value in defines(opts).items():
+        lines += ["#undef %s" % name, "#define %s %d" % (name, value)]
+    path.write_text("\n".join(lines) + "\n")
+    return path
+
+
+def parse(text):
+    """Return {workload: {key: value}} from bench output."""
+    results = {}
+    for line in text.splitlines():
+        m = SWEEP_RE.match(line.strip())
+        if not m:
+            continue
+        fields = dict(kv.split("=", 1) for kv in m.group(1).split())
+        name = fields.pop("workload")
+        results[name] = {k: float(v) for k, v in fields.items()}
+    return results
+
+
+def summarise(results):
+    """Collapse per-workload lines into one row per configuration."""
+    any_run = next(iter(results.values()))
+    matched = all(r.get("lwip_match", 1) for r in results.values())
+    if not matched:
+        print("warning: the linked lwIP does not use the requested options; "
+              "rebuild lwIP with them (values shown are the effective ones, "
+              "row left out of the Pareto front)", file=sys.stderr)
+    row = {k: int(any_run[k]) for k in OPTIONS}
+    row["matched"] = matched
+    row["rx_mbps"] = results.get("rx", {}).get("mbps", 0.0)
+    row["tx_mbps"] = results.get("tx", {}).get("mbps", 0.0)
+    row["p50_us"] = int(results.get("echo", {}).get("p50_us", 0))
+    row["p99_us"] = int(results.get("echo", {}).get("p99_us", 0))
+    row["errors"] = int(sum(r.get("errors", 0) for r in results.values()))
+    # Static pools are paid up front; the heap peak is what the workload
+    # added on top.
+    row["memory"] = int(max(r["static_bytes"] + r["heap_peak"]
+                            for r in results.values()))
+    row["memp_peak"] = int(max(r["memp_peak"] for r in results.values()))
+    return row
+
+
+def dominates(a, b):
+    better_or_equal = (a["rx_mbps"] >= b["rx_mbps"] and
+                       a["tx_mbps"] >= b["tx_mbps"] and
+                       a["p99_us"] <= b["p99_us"] and
+                       a["memory"] <= b["memory"])
+    strictly = (a["rx_mbps"] > b["rx_mbps"] or a["tx_mbps"] > b["tx_mbps"] or
+                a["p99_us"] < b["p99_us"] or a["memory"] < b["memory"])
+    return better_or_equal and strictly
+
+
+def usable(row):
+    # A mismatched row measured the effective options, not the requested
+    # ones, so it would duplicate another configuration.
+    return row["matched"] and not row["errors"]
+
+
+def pareto(rows):
+    valid = [r for r in rows if usable(r)]
+    return [r for r in valid if not any(dominates(o, r) for o in valid)]
+
+
+def print_table(rows, front, budget):
+    cols = OPTIONS + ("rx_mbps", "tx_mbps", "p50_us", "p99_us", "memory",
+                      "memp_peak", "errors")
+    print(" | ".join(cols) + " | pareto")
+    print("-|-".join("-" * len(c) for c in cols) + "-|-------")
+    for r in sorted(rows, key=lambda r: r["memory"]):
+        cells = [("%.3f" % r[c]) if isinstance(r[c], float) else str(r[c])
+                 for c in cols]
+        mark = "*" if r in front else ""
+        if not r["matched"]:
+            mark += " (options not applied)"
+        if budget and r["memory"] > budget:
+            mark += " (over budget)"
+        print(" | ".join(cells) + " | " + mark)
+
+    fitting = [r for r in front if not budget or r["memory"] <= budget]
+    if fitting:
+        best = max(fitting, key=lambda r: (r["rx_mbps"] + r["tx_mbps"],
+                                           -r["p99_us"]))
+        print("\nbest within budget: %s" % tag(best))
+
+
+def run_sweep(args):
+    rows = []
+    with tempfile.TemporaryDirectory() as tmp:
+        for opts in matrix(args):
+            fmt = {"defines": " ".join("-D%s=%d" % kv
+                                       for kv in defines(opts).items()),
+                   "header": str(write_header(opts, tmp)),
+                   "tag": tag(opts)}
+            print("[sweep] %s" % fmt["tag"], file=sys.stderr)
+            build = subprocess.run(args.build.format(**fmt), shell=True)
+            if build.returncode:
+                print("[sweep] build failed, skipped", file=sys.stderr)
+                continue
+            run = subprocess.run(args.run.format(**fmt), shell=True,
+                                 capture_output=True, text=True,
+                                 timeout=args.timeout)
+            if args.keep:
+                out = pathlib.Path(args.keep) / ("%s.log" % fmt["tag"])
+                out.parent.mkdir(parents=True, exist_ok=True)
+                out.write_text(run.stdout)
+            results = parse(run.stdout)
+            if not results:
+                print("[sweep] no SWEEP lines, skipped", file=sys.stderr)
+                continue
+            rows.append(summarise(results))
+    return rows
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--build", help="build command template")
+    ap.add_argument("--run", help="flash/run command template")
+    ap.add_argument("--parse", nargs="*", metavar="LOG",
+                    help="summarise saved bench outputs instead of running")
+    ap.add_argument("--mss", type=int_list, default=[536, 1460])
+    ap.add_argument("--wnd-mss", type=int_list, default=[2, 4, 8],
+                    help="TCP_WND as multiples of TCP_MSS")
+    ap.add_argument("--snd-buf-mss", type=int_list, default=[2, 4, 8],
+                    help="TCP_SND_BUF as multiples of TCP_MSS")
+    ap.add_argument("--pbuf-pool", type=int_list, default=[8, 16, 24])
+    ap.add_argument("--tcp-seg", type=int_list, default=[16, 32])
+    ap.add_argument("--budget", type=int, default=0,
+                    help="RAM budget in bytes for the recommendation")
+    ap.add_argument("--timeout", type=int, default=300,
+                    help="seconds allowed per run")
+    ap.add_argument("--keep", metavar="DIR", help="save raw run outputs")
+    args = ap.parse_args()
+
+    if args.parse is not None:
+        rows = [summarise(r) for r in
+                (parse(pathlib.Path(p).read_text()) for p in args.parse) if r]
+    elif args.build and args.run:
+        rows = run_sweep(args)
+    else:
+        ap.error("either --parse or both --build and --run are required")
+
+    if not rows:
+        print("no results", file=sys.stderr)
+        return 1
+    print_table(rows, pareto(rows), args.budget)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())